@@ -1,8 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 #include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "JsonBlockInfoReader.h"
+#include "BakedBlockModel.h"
+#include "AtlasRegion.h"
 
 class BlockCache {
 public:
@@ -43,12 +51,34 @@ public:
         return blockInfos[static_cast<int>(block)];
     }
 
+    // Resolves every model face against the atlas into the quad table the mesher reads.
+    // Needs loadAll and the atlas, so it runs after TextureManager::bindTextures.
+    void bakeModels(const std::unordered_map<std::string, AtlasRegion>& atlasRegions);
+
+    bool isBaked() const { return baked; }
+
+    // Hash of everything meshing reads from here: the baked quads and models and the
+    // opacity of each block. Part of every ChunkMeshCache key, set by bakeModels.
+    uint64_t getMeshingHash() const { return meshingHash; }
+
+    const BakedBlockModel& getBakedModel(Blocks block) const {
+        return bakedModels[static_cast<int>(block)];
+    }
+
+    std::span<const BakedQuad> getBakedQuads(const BakedBlockModel& model, int face) const {
+        return { bakedQuads.data() + model.first[face], model.count[face] };
+    }
+
 private:
     BlockCache() = default;
 
     static constexpr int BLOCK_COUNT = static_cast<int>(Blocks::Count);
     std::array<BlockModel, BLOCK_COUNT> blockModels;
     std::array<BlockInfo, BLOCK_COUNT> blockInfos;
+    std::array<BakedBlockModel, BLOCK_COUNT> bakedModels;
+    std::vector<BakedQuad> bakedQuads;
+    bool baked = false;
+    uint64_t meshingHash = 0;
 
     BlockModel getDefaultBlockModel() const {
         return BlockModel{};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <unordered_map>
+#include <array>
 #include <string>
 #include <functional>
 #include <memory>
@@ -15,6 +16,13 @@ struct BlockIDHash {
     }
 };
 
+// Shared - the type has no per-block state, every placed block is the same immutable instance.
+// PerInstance - the type has properties, each placed block gets its own object.
+enum class BlockInstanceMode {
+    Shared,
+    PerInstance
+};
+
 class BlockFactory {
 public:
     using BlockConstructor = std::function<std::shared_ptr<Block>()>;
@@ -24,8 +32,12 @@ public:
         return instance;
     }
 
-    void registerBlock(Blocks blockType, BlockConstructor constructor) {
+    // Registration runs during static initialization, before any chunk reads the tables below
+    void registerBlock(Blocks blockType, BlockConstructor constructor, BlockInstanceMode mode = BlockInstanceMode::Shared) {
         std::lock_guard<std::mutex> lock(_mutex);
+        int idx = static_cast<int>(blockType);
+        _prototypes[idx] = constructor();
+        _modes[idx] = mode;
         _registry[blockType] = std::move(constructor);
     }
 
@@ -47,8 +59,17 @@ public:
     }
 
     std::shared_ptr<Block> getSharedAirBlock() {
-        static std::shared_ptr<Block> airBlock = create(Blocks::Air);
-        return airBlock;
+        return getSharedBlock(Blocks::Air);
+    }
+
+    // Immutable instance of the type. For PerInstance types it is the default state,
+    // used for reads where no per-position instance exists. Lock free.
+    const std::shared_ptr<Block>& getSharedBlock(Blocks blockType) const {
+        return _prototypes[static_cast<int>(blockType)];
+    }
+
+    bool isShared(Blocks blockType) const {
+        return _modes[static_cast<int>(blockType)] == BlockInstanceMode::Shared;
     }
 
 private:
@@ -58,6 +79,10 @@ private:
     BlockFactory(const BlockFactory&) = delete;
     BlockFactory& operator=(const BlockFactory&) = delete;
 
+    static constexpr int BLOCK_COUNT = static_cast<int>(Blocks::Count);
+
     std::unordered_map<Blocks, BlockConstructor, BlockIDHash> _registry;
+    std::array<std::shared_ptr<Block>, BLOCK_COUNT> _prototypes;
+    std::array<BlockInstanceMode, BLOCK_COUNT> _modes{};
     std::mutex _mutex;
 };
\ No newline at end of file
@@ -2,16 +2,25 @@
 
 #include "BlockFactory.h"
 
-#define REGISTER_BLOCK(id, className)                         \
+#define REGISTER_BLOCK_WITH_MODE(id, className, mode)         \
     namespace {                                               \
         struct className##Registrar {                         \
             className##Registrar() {                          \
                 BlockFactory::getInstance().registerBlock(    \
                     id, []() {                                \
                         return std::make_shared<className>();\
-                    }                                         \
+                    },                                        \
+                    mode                                      \
                 );                                            \
             }                                                 \
         };                                                    \
         static className##Registrar global_##className##Registrar; \
     }
+
+// Stateless block: one shared instance for every placed block
+#define REGISTER_BLOCK(id, className) \
+    REGISTER_BLOCK_WITH_MODE(id, className, BlockInstanceMode::Shared)
+
+// Block with properties: one instance per placed block, kept in the chunk side table
+#define REGISTER_STATEFUL_BLOCK(id, className) \
+    REGISTER_BLOCK_WITH_MODE(id, className, BlockInstanceMode::PerInstance)
@@ -0,0 +1,145 @@
+#include "BlockCache.h"
+
+#include <string_view>
+
+namespace {
+
+// Model face names in BlockFace.h order
+const std::array<std::string, 6> faceKeys = {"east","west","up","down","south","north"};
+
+const glm::vec3 faceNormals[6] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+
+void getFaceVertices(const BlockModelElement& e, int face, glm::vec3 out[4]) {
+    glm::vec3 f = glm::vec3(e.from[0], e.from[1], e.from[2]) / 16.0f;
+    glm::vec3 t = glm::vec3(e.to[0],   e.to[1],   e.to[2])   / 16.0f;
+    switch (face) {
+        case 0: // east
+            out[0] = {t.x, f.y, f.z};
+            out[1] = {t.x, f.y, t.z};
+            out[2] = {t.x, t.y, t.z};
+            out[3] = {t.x, t.y, f.z};
+            break;
+        case 1: // west
+            out[0] = {f.x, f.y, t.z};
+            out[1] = {f.x, f.y, f.z};
+            out[2] = {f.x, t.y, f.z};
+            out[3] = {f.x, t.y, t.z};
+            break;
+        case 2: // up
+            out[0] = {f.x, t.y, f.z};
+            out[1] = {t.x, t.y, f.z};
+            out[2] = {t.x, t.y, t.z};
+            out[3] = {f.x, t.y, t.z};
+            break;
+        case 3: // down
+            out[0] = {f.x, f.y, t.z};
+            out[1] = {t.x, f.y, t.z};
+            out[2] = {t.x, f.y, f.z};
+            out[3] = {f.x, f.y, f.z};
+            break;
+        case 4: // south
+            out[0] = {t.x, f.y, t.z};
+            out[1] = {f.x, f.y, t.z};
+            out[2] = {f.x, t.y, t.z};
+            out[3] = {t.x, t.y, t.z};
+            break;
+        default: // north
+            out[0] = {f.x, f.y, f.z};
+            out[1] = {t.x, f.y, f.z};
+            out[2] = {t.x, t.y, f.z};
+            out[3] = {f.x, t.y, f.z};
+            break;
+    }
+}
+
+// Field by field, the padding of BakedQuad would make the hash differ between runs
+template<typename T>
+void appendBytes(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+void BlockCache::bakeModels(const std::unordered_map<std::string, AtlasRegion>& atlasRegions) {
+    bakedQuads.clear();
+    std::unordered_map<std::string, uint16_t> textureNumbers;
+
+    for (int i = 0; i < BLOCK_COUNT; ++i) {
+        const BlockModel& model = blockModels[i];
+        BakedBlockModel& bakedModel = bakedModels[i];
+        bakedModel = BakedBlockModel{};
+
+        for (int face = 0; face < 6; ++face) {
+            bakedModel.first[face] = static_cast<uint32_t>(bakedQuads.size());
+            for (const auto& element : model.elements) {
+                auto faceIt = element.faces.find(faceKeys[face]);
+                if (faceIt == element.faces.end()) continue;
+                const BlockModelFace& faceData = faceIt->second;
+
+                std::string texKey = faceData.texture;
+                if (!texKey.empty() && texKey[0] == '#') {
+                    texKey = texKey.substr(1);
+                }
+                auto textureIt = model.textures.find(texKey);
+                if (textureIt == model.textures.end()) {
+                    Logger::getInstance().Log("Texture key not found: " + texKey, LogLevel::Warning);
+                    continue;
+                }
+                auto regionIt = atlasRegions.find(textureIt->second + ".png");
+                if (regionIt == atlasRegions.end()) {
+                    Logger::getInstance().Log("Texture not found in atlas: " + textureIt->second, LogLevel::Warning);
+                    continue;
+                }
+                const AtlasRegion& region = regionIt->second;
+
+                BakedQuad quad;
+                getFaceVertices(element, face, quad.vertices);
+                quad.normal = faceNormals[face];
+                quad.uvs[0] = glm::vec2(faceData.uv[0], faceData.uv[1]) / 16.0f;
+                quad.uvs[1] = glm::vec2(faceData.uv[2], faceData.uv[1]) / 16.0f;
+                quad.uvs[2] = glm::vec2(faceData.uv[2], faceData.uv[3]) / 16.0f;
+                quad.uvs[3] = glm::vec2(faceData.uv[0], faceData.uv[3]) / 16.0f;
+                quad.atlasRect = glm::vec4(region.u0, region.v0, region.u1 - region.u0, region.v1 - region.v0);
+                quad.texture = textureNumbers.try_emplace(regionIt->first, static_cast<uint16_t>(textureNumbers.size())).first->second;
+                // An opaque block hides all of its faces behind opaque neighbours, as the mesher always did
+                quad.cull = blockInfos[i].isOpaque;
+                bakedQuads.push_back(quad);
+            }
+            bakedModel.count[face] = static_cast<uint32_t>(bakedQuads.size()) - bakedModel.first[face];
+            bakedModel.isEmpty = bakedModel.isEmpty && bakedModel.count[face] == 0;
+        }
+
+        // A single 16^3 element showing each whole texture on each side: the only model whose
+        // faces still look right when neighbours are merged into one tiled quad
+        if (model.elements.size() == 1) {
+            const BlockModelElement& element = model.elements.front();
+            bool cube = element.from == std::vector<float>{ 0, 0, 0 } && element.to == std::vector<float>{ 16, 16, 16 } &&
+                        element.rotation.angle == 0.0f;
+            for (int face = 0; face < 6 && cube; ++face) {
+                auto faceIt = element.faces.find(faceKeys[face]);
+                cube = bakedModel.count[face] == 1 && faceIt != element.faces.end() &&
+                       faceIt->second.uv == std::vector<float>{ 0, 0, 16, 16 };
+            }
+            bakedModel.isCube = cube;
+        }
+    }
+
+    std::string bytes;
+    for (const auto& quad : bakedQuads) {
+        appendBytes(bytes, quad.vertices);
+        appendBytes(bytes, quad.normal);
+        appendBytes(bytes, quad.uvs);
+        appendBytes(bytes, quad.atlasRect);
+        appendBytes(bytes, quad.texture);
+        appendBytes(bytes, quad.cull);
+    }
+    for (int i = 0; i < BLOCK_COUNT; ++i) {
+        appendBytes(bytes, bakedModels[i].first);
+        appendBytes(bytes, bakedModels[i].count);
+        appendBytes(bytes, bakedModels[i].isCube);
+        appendBytes(bytes, bakedModels[i].isEmpty);
+        appendBytes(bytes, blockInfos[i].isOpaque);
+    }
+    meshingHash = std::hash<std::string_view>{}(bytes);
+    baked = true;
+}
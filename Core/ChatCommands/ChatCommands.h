@@ -4,7 +4,9 @@ enum class ChatCommandID {
     Help,
     Clear,
     Tp,
-    ChooseBlock
+    ChooseBlock,
+    Fill,
+    Mesher
 };
 
 static const std::unordered_map<std::string, ChatCommandID> ChatCommandNameMap = {
@@ -12,4 +14,6 @@ static const std::unordered_map<std::string, ChatCommandID> ChatCommandNameMap =
     {"help", ChatCommandID::Help},
     {"clear", ChatCommandID::Clear},
     {"chblock", ChatCommandID::ChooseBlock},
+    {"fill", ChatCommandID::Fill},
+    {"mesher", ChatCommandID::Mesher},
 };
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IChatCommand.h"
+#include "ChatController.h"
+#include "ServiceLocator.h"
+#include <sstream>
+#include <algorithm>
+#include "glm/glm.hpp"
+#include "Blocks.h"
+#include "BlockPos.h"
+
+class FillCommand : public IChatCommand {
+public:
+    FillCommand(ChatController& controller) : _controller(controller) {}
+
+    void execute(const std::string& args) override {
+        std::istringstream iss(args);
+        glm::ivec3 a, b;
+        int blockId;
+
+        if (!(iss >> a.x >> a.y >> a.z >> b.x >> b.y >> b.z >> blockId)
+            || blockId < 0 || blockId >= static_cast<int>(Blocks::Count)) {
+            _controller.addMessage("Usage: /fill <x1> <y1> <z1> <x2> <y2> <z2> <blockid>");
+            return;
+        }
+
+        glm::ivec3 from = glm::min(a, b);
+        glm::ivec3 to = glm::max(a, b);
+        glm::ivec3 extent = to - from + 1;
+        if (static_cast<long long>(extent.x) * extent.y * extent.z > MAX_VOLUME) {
+            _controller.addMessage("Fill volume is limited to " + std::to_string(MAX_VOLUME) + " blocks");
+            return;
+        }
+
+        auto edit = ServiceLocator::GetWorld()->getChunkController().beginEdit();
+        for (int z = from.z; z <= to.z; ++z)
+        for (int y = from.y; y <= to.y; ++y)
+        for (int x = from.x; x <= to.x; ++x) {
+            edit.set(BlockPos{ glm::ivec3(x, y, z) }, static_cast<Blocks>(blockId));
+        }
+
+        const size_t blocks = edit.size();
+        const size_t chunks = edit.chunkCount();
+        const size_t applied = edit.commit();
+
+        std::string message = "Filled " + std::to_string(applied) + " blocks in " + std::to_string(chunks) + " chunks";
+        if (applied < blocks) {
+            message += ", " + std::to_string(blocks - applied) + " unchanged or in chunks not loaded";
+        }
+        _controller.addMessage(message);
+    }
+
+private:
+    static constexpr int MAX_VOLUME = 64 * 64 * 64;
+
+    ChatController& _controller;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "IChatCommand.h"
+#include "ChatController.h"
+#include "ServiceLocator.h"
+#include "ChunkMeshBuilder.h"
+#include <sstream>
+
+class MesherCommand : public IChatCommand {
+public:
+    MesherCommand(ChatController& controller) : _controller(controller) {}
+
+    void execute(const std::string& args) override {
+        std::istringstream iss(args);
+        std::string mode;
+
+        if (!(iss >> mode)) {
+            _controller.addMessage(std::string("Mesher: ") + toString(ChunkMeshBuilder::getMeshingMode()));
+            return;
+        }
+        if (mode != "faces" && mode != "greedy") {
+            _controller.addMessage("Usage: /mesher <faces|greedy>");
+            return;
+        }
+
+        ChunkMeshBuilder::setMeshingMode(mode == "greedy" ? MeshingMode::Greedy : MeshingMode::Faces);
+        ServiceLocator::GetWorld()->getChunkController().remeshAll();
+
+        _controller.addMessage("Mesher: " + mode + ", loaded chunks are rebuilt");
+    }
+
+    static const char* toString(MeshingMode mode) {
+        return mode == MeshingMode::Greedy ? "greedy" : "faces";
+    }
+
+private:
+    ChatController& _controller;
+};
@@ -7,7 +7,11 @@
 #include "ClearCommand.h"
 #include "TpCommand.h"
 #include "ChooseBlockCommand.h"
+#include "FillCommand.h"
+#include "MesherCommand.h"
 
 REGISTER_CHAT_COMMAND(ChatCommandID::Clear, ClearCommand, *ServiceLocator::GetChatController());
 REGISTER_CHAT_COMMAND(ChatCommandID::Tp, TpCommand, *ServiceLocator::GetChatController());
-REGISTER_CHAT_COMMAND(ChatCommandID::ChooseBlock, ChooseBlockCommand, *ServiceLocator::GetChatController());
\ No newline at end of file
+REGISTER_CHAT_COMMAND(ChatCommandID::ChooseBlock, ChooseBlockCommand, *ServiceLocator::GetChatController());
+REGISTER_CHAT_COMMAND(ChatCommandID::Fill, FillCommand, *ServiceLocator::GetChatController());
+REGISTER_CHAT_COMMAND(ChatCommandID::Mesher, MesherCommand, *ServiceLocator::GetChatController());
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// One face of a model element with its texture resolved: corners in block space (0..1),
+// tile UVs and the atlas rectangle, ready to be offset and emitted
+struct BakedQuad {
+    glm::vec3 vertices[4];
+    glm::vec3 normal;
+    glm::vec2 uvs[4];
+    glm::vec4 atlasRect;   // u0, v0, width, height
+    uint16_t texture;      // same number for the same atlas region
+    bool cull;             // hidden when the neighbour on this side is opaque
+};
+
+// Where the quads of one block lie in BlockCache's quad table, per side in BlockFace.h order
+struct BakedBlockModel {
+    std::array<uint32_t, 6> first{};
+    std::array<uint32_t, 6> count{};
+    bool isCube = false;   // one 16^3 element with whole textures on all sides: faces can be merged
+    bool isEmpty = true;   // no quads at all
+};
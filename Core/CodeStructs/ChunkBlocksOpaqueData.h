@@ -1,21 +1,72 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cassert>
+
+// Opacity of a 32^3 chunk as one 32-bit mask per (y, z) row, bit x set = opaque.
+// Row index follows the block index order: y + SIZE * z.
 struct ChunkBlocksOpaqueData
 {
     static constexpr int SIZE = 32;
+    static constexpr int ROWS = SIZE * SIZE;
 
-    ChunkBlocksOpaqueData() 
-        : data(SIZE*SIZE*SIZE, false) {}
+    // Storage is allocated on the first opaque block, fully transparent chunks cost nothing
+    ChunkBlocksOpaqueData() = default;
 
     bool isOpaque(int x, int y, int z) const {
         assert(inBounds(x, y, z));
-        return data[toIndex(x, y, z)];
+        return (getRow(y, z) >> x) & 1u;
     }
 
     void setOpaque(int x, int y, int z, bool opaque) {
         assert(inBounds(x, y, z));
-        data[toIndex(x, y, z)] = opaque;
-    } 
+        if (rows.empty()) {
+            if (!opaque) return;
+            rows.assign(ROWS, 0);
+        }
+        uint32_t& row = rows[toRowIndex(y, z)];
+        const uint32_t bit = 1u << x;
+        row = opaque ? (row | bit) : (row & ~bit);
+    }
+
+    uint32_t getRow(int y, int z) const {
+        if (rows.empty()) return 0;
+        return rows[toRowIndex(y, z)];
+    }
+
+    void setRow(int y, int z, uint32_t mask) {
+        if (rows.empty()) {
+            if (mask == 0) return;
+            rows.assign(ROWS, 0);
+        }
+        rows[toRowIndex(y, z)] = mask;
+    }
+
+    // All ROWS masks in row index order, nullptr while the chunk has no opaque block
+    const uint32_t* getRows() const {
+        return rows.empty() ? nullptr : rows.data();
+    }
+
+    void fill(bool opaque) {
+        if (opaque) {
+            rows.assign(ROWS, 0xFFFFFFFFu);
+        } else {
+            clear();
+        }
+    }
+
+    // Keeps the allocation so a recycled chunk can reuse it
+    void clear() {
+        rows.clear();
+    }
+
+    // Frees the allocation as well, for a parked chunk (see Chunk::park)
+    void release() {
+        std::vector<uint32_t>().swap(rows);
+    }
 
     std::string toDebugString() const {
         std::ostringstream oss;
@@ -28,7 +79,7 @@ struct ChunkBlocksOpaqueData
                 for (int x = 0; x < SIZE; ++x) {
                     if (isOpaque(x, y, z)) {
                         ++count;
-                        oss << "Opaque Block at (" 
+                        oss << "Opaque Block at ("
                             << x << ", " << y << ", " << z << ")\n";
                     }
                 }
@@ -44,13 +95,13 @@ struct ChunkBlocksOpaqueData
         return oss.str();
     }
 
-private:
-    std::vector<bool> data;
-
-    static int toIndex(int x, int y, int z) {
-        return x + SIZE * (y + SIZE * z);
+    static int toRowIndex(int y, int z) {
+        return y + SIZE * z;
     }
 
+private:
+    std::vector<uint32_t> rows;
+
     static bool inBounds(int x, int y, int z) {
         return (x >= 0 && x < SIZE) && (y >= 0 && y < SIZE) && (z >= 0 && z < SIZE);
     }
@@ -5,5 +5,6 @@
 struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
-    glm::vec2 texCoord;
+    glm::vec2 texCoord;   // in texture repeats, wrapped into atlasRect by the shader
+    glm::vec4 atlasRect;  // u0, v0, width, height of the texture in the atlas
 };
\ No newline at end of file
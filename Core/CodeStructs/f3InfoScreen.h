@@ -9,6 +9,13 @@
 #include "FontsLoader.h"
 
 #include "BlockCache.h"
+#include "ChunkPool.h"
+#include "ChunkSaver.h"
+#include "AsyncFileIO.h"
+#include "ChunkMeshCache.h"
+#include "ChunkMeshBuilder.h"
+#include "ChunkMeshScheduler.h"
+#include "ChunkUploadScheduler.h"
 
 struct f3InfoScreen
 {
@@ -18,7 +25,11 @@ struct f3InfoScreen
     glm::ivec3 chunkPos{};
     glm::ivec3 blockPos{};
     std::string facedBlockInfo;
-
+    std::string chunkPoolInfo;
+    std::string chunkSaverInfo;
+    std::string chunkIoInfo;
+    std::string meshCacheInfo;
+    std::string uploadInfo;
 
 
     void update(float deltaTime, const Camera& camera, World& world, const std::optional<RaycastHit>& raycastHit) {
@@ -43,6 +54,42 @@ struct f3InfoScreen
         } else {
             facedBlockInfo = "No block hit";
         }
+
+        auto poolStats = ChunkPool::getInstance().getStats();
+        chunkPoolInfo = "Chunk pool: " + std::to_string(poolStats.inUse) + " in use, high-water " +
+                        std::to_string(poolStats.highWater) + ", idle " + std::to_string(poolStats.pooled) +
+                        ", recycled " + std::to_string(static_cast<int>(poolStats.recycleRate() * 100.0)) + "%" +
+                        ", parked " + std::to_string(Chunk::getParkedCount());
+
+        auto saverStats = ChunkSaver::getInstance().getStats();
+        chunkSaverInfo = "Chunk saves: " + std::to_string(saverStats.pending) + " pending, " +
+                         std::to_string(saverStats.written) + " written, " +
+                         std::to_string(saverStats.coalesced) + " coalesced, " +
+                         std::to_string(saverStats.failed) + " failed";
+
+        auto& asyncIo = AsyncFileIO::getInstance();
+        chunkIoInfo = std::string("Chunk I/O: ") + asyncIo.getBackendName() + ", " +
+                      std::to_string(asyncIo.getPending()) + " in flight";
+
+        auto& meshCache = ChunkMeshCache::getInstance();
+        auto meshStats = meshCache.getStats();
+        auto schedulerStats = ChunkMeshScheduler::getInstance().getStats();
+        meshCacheInfo = std::string("Mesher: ") +
+                        (ChunkMeshBuilder::getMeshingMode() == MeshingMode::Greedy ? "greedy" : "faces") + ", " +
+                        std::to_string(schedulerStats.queued) + " queued, " +
+                        std::to_string(schedulerStats.running) + " building, " +
+                        (!meshCache.isEnabled() ? std::string("mesh cache off") :
+                        "mesh cache " + std::to_string(meshStats.entries) + " meshes, " +
+                        std::to_string(meshStats.bytes / (1024 * 1024)) + " MB, hit rate " +
+                        std::to_string(static_cast<int>(meshStats.hitRate() * 100.0)) + "%");
+
+        auto uploadStats = ChunkUploadScheduler::getInstance().getStats();
+        uploadInfo = "Mesh uploads: " + std::to_string(uploadStats.queued) + " queued, " +
+                     std::to_string(uploadStats.uploads) + " last frame, " +
+                     std::to_string(uploadStats.bytes / 1024) + " KB in " +
+                     std::to_string(uploadStats.uploadMs).substr(0, 4) + " ms, stall " +
+                     std::to_string(uploadStats.stallMs).substr(0, 4) + " ms, " +
+                     (uploadStats.stagingRing ? "staging ring" : "direct");
     }
 
     static std::string toString(const glm::vec3& vec) {
@@ -88,6 +135,11 @@ struct f3InfoScreen
         drawLine(toString(playerPos, "Coords:"), 3);
         drawLine("View distance: " + toString(viewDistance), 4);
         drawLine(facedBlockInfo, 5);
+        drawLine(chunkPoolInfo, 6);
+        drawLine(chunkSaverInfo, 7);
+        drawLine(chunkIoInfo, 8);
+        drawLine(meshCacheInfo, 9);
+        drawLine(uploadInfo, 10);
     }
 private:
     BlockCache& _blockCache = BlockCache::getInstance();
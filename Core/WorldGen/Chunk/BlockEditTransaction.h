@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <utility>
+
+#include "Blocks.h"
+#include "BlockPos.h"
+#include "ChunkPos.h"
+
+class ChunkController;
+
+// Collects block edits by world position and applies them grouped by chunk.
+// On commit every chunk an edit changed is written, remeshed and saved once, and every
+// neighbour whose border changed is remeshed once, however many blocks changed.
+// Edits that change nothing leave their chunk clean and unsaved.
+// Edits that were never committed are discarded.
+class BlockEditTransaction {
+public:
+    explicit BlockEditTransaction(ChunkController& controller);
+
+    BlockEditTransaction(const BlockEditTransaction&) = delete;
+    BlockEditTransaction& operator=(const BlockEditTransaction&) = delete;
+    BlockEditTransaction(BlockEditTransaction&&) = default;
+
+    // Later edits of the same position win
+    void set(const BlockPos& worldPos, Blocks id);
+    void breakBlock(const BlockPos& worldPos);
+
+    size_t size() const { return _editCount; }
+    size_t chunkCount() const { return _edits.size(); }
+
+    // Returns the number of edits that changed a block. Edits of chunks that are not
+    // loaded, breaking air and placing a block over the same stateless block do not count.
+    size_t commit();
+
+private:
+    ChunkController* _controller;
+    // Local positions per chunk, in the order they were set
+    std::unordered_map<ChunkPos, std::vector<std::pair<BlockPos, Blocks>>> _edits;
+    size_t _editCount = 0;
+};
@@ -1,16 +1,26 @@
 #pragma once
 
+#include <array>
 #include <vector>
+#include <unordered_map>
 #include <atomic>
 #include <memory>
 
 #include "Blocks.h"
 #include "BlockFactory.h"
 #include "ChunkBlocksOpaqueData.h"
+#include "ChunkBlockStorage.h"
+#include "ChunkSnapshot.h"
 #include "BlockPos.h"
 #include "Shader.h"
 #include "ChunkMesh.h"
 
+// What Chunk::applyEdits changed
+struct ChunkEditResult {
+    size_t applied = 0;       // edits that changed a block
+    uint8_t borderFaces = 0;  // bit per faces[] entry whose neighbour chunk borders a changed block
+};
+
 class Chunk {
 public:
     static constexpr int CHUNK_SIZE = 32;
@@ -19,42 +29,123 @@ public:
 
     Chunk(const ChunkPos& pos);
 
+    // Turns the chunk into an empty one at a new position, keeping its allocations (see ChunkPool)
+    void reset(const ChunkPos& pos);
+
     void markSavingStarted();
     void markSavingFinished();
     bool isDeletable() const;
 
-    std::shared_ptr<Block>& getBlockPtr(BlockPos pos);
-    const std::shared_ptr<Block>& getBlockPtr(BlockPos pos) const;
-
-    Block& getBlock(BlockPos pos);
+    // Stateless types resolve to the one shared instance, so blocks are read-only here;
+    // changes go through applyEdits
     const Block& getBlock(BlockPos pos) const;
 
-    void setBlock(BlockPos pos, const Blocks blockType);
-    void breakBlock(BlockPos pos);
+    // Applies local edits in order and marks the mesh dirty once if any changed a block.
+    // Breaking air and placing a stateless block over the same type change nothing and
+    // are not counted. Saving and neighbour remeshing are left to the caller (see
+    // BlockEditTransaction).
+    ChunkEditResult applyEdits(const std::vector<std::pair<BlockPos, Blocks>>& edits);
+
+    const ChunkBlockStorage& getBlocks() const;
 
-    const std::vector<std::shared_ptr<Block>>& getBlocks() const;
+    // O(1) plus the side table size. Call from the thread that edits the chunk,
+    // or after the chunk has left ChunkMemoryContainer.
+    ChunkSnapshot snapshot() const;
+    // Bumped on every block write
+    uint64_t getVersion() const;
+    // Replaces the contents with a snapshot's, sharing its storage until the next write
+    void restore(const ChunkSnapshot& snapshot);
 
+    // Dirty = edited since the version last handed to ChunkSaver or read from disk
+    bool isDirty() const;
+    void markSaved(uint64_t savedVersion);
+
+    const std::unordered_map<int, std::shared_ptr<Block>>& getBlockEntities() const;
+    void setBlockProperties(BlockPos pos, const std::string& properties);
+
+    // Full one-pass rebuild; edits keep the masks up to date on their own
     void updateChunkBlocksOpaqueData();
     ChunkBlocksOpaqueData* getBlocksOpaqueData();
+    const ChunkBlocksOpaqueData& getBlocksOpaqueData() const;
+
+    // O(1): uniform air chunk, nothing to mesh, shade or store
+    bool isEmpty() const;
+    // False when there is neither an uploaded mesh nor a pending rebuild
+    bool hasGeometry() const;
 
     void render(Shader shader, const glm::vec3& sunDirection, const glm::vec3& sunColor);
 
-    void markChunkDirty();
+    // Urgent: the rebuild follows a block edit and may take the priority lane
+    void markChunkDirty(bool urgent = false);
+
+    // See ChunkMesh::takeJob and ChunkMesh::finishJob. Main thread only.
+    std::unique_ptr<ChunkMeshJob> takeMeshJob();
+    bool finishMeshJob(ChunkMeshJob& job);
+    // For ChunkUploadScheduler
+    ChunkMesh& getMesh() { return _mesh; }
 
     int toIndex(BlockPos pos) const;
 
     const ChunkPos getChunkPos() const;
 
-    void setBlocks(const std::vector<std::pair<BlockPos, Blocks>>& changes);
+    // Bulk path for load and generation: takes the storage as is, rebuilds the
+    // side table and opacity in one pass and marks the chunk dirty. No onPlace
+    // and no neighbour updates; ChunkMemoryContainer reports the chunk once it is
+    // inserted so the main thread can remesh its neighbours.
+    void assignBlocks(std::shared_ptr<ChunkBlockStorage> storage);
 
     void renderDepth(Shader& depthShader);
 
-    void updateNearChunks(glm::ivec3 localPos);
-    void updateNeighborMesh(glm::ivec3 offset);
+    // Out-of-core residency: a clean chunk gives up its block storage, opacity masks and
+    // CPU mesh arrays and keeps only what rendering needs. Block accessors require a
+    // resident chunk; ChunkController::getChunk brings the blocks back first (ChunkSaver,
+    // the region mapping or the generator). Main thread only. False when dirty, empty,
+    // waiting for a remesh or its mesh job, or already parked.
+    bool park();
+    bool isParked() const;
+    // Puts back the blocks park() dropped. The version is left alone, the chunk stays clean.
+    void unpark(std::shared_ptr<const ChunkBlockStorage> storage);
+
+    // Stamps the access clock, ChunkController does it when it hands the chunk out. Main thread only.
+    void touch();
+    // Value of the access clock at the last touch(), see advanceAccessClock
+    uint32_t getLastAccess() const;
+    // Ticked once per ChunkController::update
+    static void advanceAccessClock();
+    static uint32_t getAccessClock();
+    static size_t getParkedCount();
+
+    // Opacity of the block layer on one side of the chunk (faces[] order), as meshing a
+    // neighbour reads it: the layer a neighbour at faces[face].neighborOffset touches.
+    // Also while parked, from the copy park() keeps, so meshing never unparks a neighbour.
+    void getBorderLayer(int face, std::array<uint32_t, CHUNK_SIZE>& layer) const;
+
+    // Bit per faces[] entry for each chunk side the local position touches
+    static uint8_t borderFaces(glm::ivec3 localPos);
 
 private:
-    std::vector<std::shared_ptr<Block>> blocks;
+    // The side table instance or the shared one, for onBreak before the block goes
+    Block& blockToNotify(int idx);
+    // Writes the id and returns the block to notify: the shared instance of a stateless
+    // type, or a new side table entry for a type with properties
+    Block& placeBlock(int idx, Blocks blockType);
+    // Storage for writing, copied first when a snapshot still shares it
+    ChunkBlockStorage& editableBlocks();
+    void clearParked();
+
+    std::shared_ptr<ChunkBlockStorage> blocks;
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> savedVersion{0};
+    // Sparse side table: voxel index -> own instance, only for PerInstance block types
+    std::unordered_map<int, std::shared_ptr<Block>> blockEntities;
     ChunkMesh _mesh;
     ChunkBlocksOpaqueData blocksOpaqueData;
     ChunkPos chunkPos;
+
+    bool parked = false;
+    // The six border layers of the opacity masks park() drops, see getBorderLayer
+    std::array<std::array<uint32_t, CHUNK_SIZE>, 6> parkedBorders{};
+    uint32_t lastAccess = 0;
+    static inline std::atomic<uint32_t> accessClock{0};
+    static inline std::atomic<size_t> parkedCount{0};
 };
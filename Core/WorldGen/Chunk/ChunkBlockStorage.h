@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include "Blocks.h"
+
+// Block ids of one chunk stored as a palette plus a bit-packed index array.
+// Index width grows 1 -> 2 -> 4 -> 8 -> 16 bits as the palette grows, so an
+// entry never straddles two 64-bit words.
+// A chunk made of a single block type is "uniform": it has 0 bits per entry and
+// no index array at all until the first write of a different block.
+class ChunkBlockStorage {
+public:
+    static constexpr int SIZE = 32;
+    static constexpr int VOLUME = SIZE * SIZE * SIZE;
+    static constexpr int MAX_BITS = 16;
+
+    ChunkBlockStorage() {
+        fill(Blocks::Air);
+    }
+
+    static int toIndex(int x, int y, int z) {
+        return x + SIZE * (y + SIZE * z);
+    }
+
+    // Uniform, 4, 8 and 16 bit widths skip the variable shifts of the general decode.
+    // Entries are packed from the low bits up, so on little-endian entry i of a 4 bit
+    // array is a nibble of byte i / 2, and of an 8 or 16 bit array byte (pair) i.
+    Blocks get(int index) const {
+        static_assert(std::endian::native == std::endian::little, "byte-aligned reads assume little-endian words");
+        assert(index >= 0 && index < VOLUME);
+        if (bitsPerEntry == 0) return palette[0];
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+        if (bitsPerEntry == 4) return palette[(bytes[index >> 1] >> ((index & 1) << 2)) & 0xF];
+        if (bitsPerEntry == 8) return palette[bytes[index]];
+        if (bitsPerEntry == 16) {
+            uint16_t entry;
+            std::memcpy(&entry, bytes + index * 2, sizeof(entry));
+            return palette[entry];
+        }
+        const uint64_t word = data[index >> wordShift];
+        return palette[(word >> ((index & slotMask) << bitsShift)) & entryMask];
+    }
+
+    uint16_t getPaletteIndex(int index) const {
+        assert(index >= 0 && index < VOLUME);
+        if (bitsPerEntry == 0) return 0;
+        const uint64_t word = data[index >> wordShift];
+        const int shift = (index & slotMask) << bitsShift;
+        return static_cast<uint16_t>((word >> shift) & entryMask);
+    }
+
+    void set(int index, Blocks id) {
+        assert(index >= 0 && index < VOLUME);
+        const uint16_t oldEntry = getPaletteIndex(index);
+        if (palette[oldEntry] == id) return;
+
+        const uint16_t newEntry = getOrAddPaletteEntry(id);
+        // getOrAddPaletteEntry may have compacted the palette and renumbered entries
+        const uint16_t currentEntry = getPaletteIndex(index);
+
+        writeIndex(index, newEntry);
+        --paletteRefs[currentEntry];
+        ++paletteRefs[newEntry];
+
+        if (paletteRefs[newEntry] == VOLUME) {
+            fill(id);
+        }
+    }
+
+    void fill(Blocks id) {
+        palette.assign(1, id);
+        paletteRefs.assign(1, VOLUME);
+        lookup.fill(NO_ENTRY);
+        lookup[static_cast<int>(id)] = 0;
+        setBitsPerEntry(0);
+        data.clear();
+    }
+
+    // Bulk load from a palette and one palette index per voxel (ChunkCodec).
+    // Duplicate or unused palette entries are folded away. False on an out of range index.
+    bool assign(const std::vector<Blocks>& sourcePalette, const std::vector<uint16_t>& indices) {
+        if (indices.size() != static_cast<size_t>(VOLUME)) return false;
+
+        // Counted per run: incrementing one counter per voxel stalls on its own store
+        std::vector<uint32_t> sourceRefs(sourcePalette.size(), 0);
+        uint16_t maxIndex = 0;
+        uint16_t runIndex = indices[0];
+        uint32_t runLength = 0;
+        for (uint16_t index : indices) {
+            maxIndex = std::max(maxIndex, index);
+            if (index != runIndex) {
+                if (runIndex < sourceRefs.size()) sourceRefs[runIndex] += runLength;
+                runIndex = index;
+                runLength = 0;
+            }
+            ++runLength;
+        }
+        if (maxIndex >= sourcePalette.size()) return false;
+        sourceRefs[runIndex] += runLength;
+
+        palette.clear();
+        paletteRefs.clear();
+        lookup.fill(NO_ENTRY);
+        std::vector<uint16_t> remap(sourcePalette.size(), NO_ENTRY);
+        for (size_t i = 0; i < sourcePalette.size(); ++i) {
+            if (sourceRefs[i] == 0) continue;
+            const int id = static_cast<int>(sourcePalette[i]);
+            if (lookup[id] == NO_ENTRY) {
+                lookup[id] = static_cast<uint16_t>(palette.size());
+                palette.push_back(sourcePalette[i]);
+                paletteRefs.push_back(0);
+            }
+            remap[i] = lookup[id];
+            paletteRefs[remap[i]] += sourceRefs[i];
+        }
+
+        if (palette.size() == 1) {
+            fill(palette[0]);
+            return true;
+        }
+
+        int bits = 1;
+        while ((size_t(1) << bits) < palette.size()) bits *= 2;
+        setBitsPerEntry(bits);
+        data.resize(wordCount(bits));
+        const int perWord = 64 >> bitsShift;
+        const uint16_t* source = indices.data();
+        for (uint64_t& word : data) {
+            uint64_t packed = 0;
+            for (int slot = 0; slot < perWord; ++slot) {
+                packed |= static_cast<uint64_t>(remap[source[slot]]) << (slot << bitsShift);
+            }
+            word = packed;
+            source += perWord;
+        }
+        return true;
+    }
+
+    bool isUniform() const {
+        return bitsPerEntry == 0;
+    }
+
+    // Only meaningful when isUniform()
+    Blocks getUniformBlock() const {
+        return palette[0];
+    }
+
+    // True when every voxel references palette entries of the given id only.
+    bool containsOnly(Blocks id) const {
+        for (size_t i = 0; i < palette.size(); ++i) {
+            if (palette[i] != id && paletteRefs[i] != 0) return false;
+        }
+        return true;
+    }
+
+    const std::vector<Blocks>& getPalette() const { return palette; }
+    const std::vector<uint32_t>& getPaletteRefs() const { return paletteRefs; }
+    const std::vector<uint64_t>& getPackedData() const { return data; }
+    int getBitsPerEntry() const { return bitsPerEntry; }
+
+    size_t getMemoryUsage() const {
+        return sizeof(*this)
+            + palette.capacity() * sizeof(Blocks)
+            + paletteRefs.capacity() * sizeof(uint32_t)
+            + data.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    static constexpr int BLOCK_COUNT = static_cast<int>(Blocks::Count);
+    static constexpr uint16_t NO_ENTRY = 0xFFFF;
+
+    std::vector<Blocks> palette;
+    std::vector<uint32_t> paletteRefs;
+    std::array<uint16_t, BLOCK_COUNT> lookup{};
+    std::vector<uint64_t> data;
+    int bitsPerEntry = 0;
+
+    // Derived from bitsPerEntry so lookups are shifts and masks only
+    int bitsShift = 0;
+    int wordShift = 6;
+    int slotMask = 63;
+    uint64_t entryMask = 1;
+
+    static size_t wordCount(int bits) {
+        return static_cast<size_t>(VOLUME) / (64 / bits);
+    }
+
+    static int log2(int value) {
+        int result = 0;
+        while ((1 << result) < value) ++result;
+        return result;
+    }
+
+    void setBitsPerEntry(int bits) {
+        bitsPerEntry = bits;
+        if (bits == 0) return;
+        bitsShift = log2(bits);
+        wordShift = 6 - bitsShift;
+        slotMask = (64 >> bitsShift) - 1;
+        entryMask = (uint64_t(1) << bits) - 1;
+    }
+
+    void writeIndex(int index, uint16_t entry) {
+        uint64_t& word = data[index >> wordShift];
+        const int shift = (index & slotMask) << bitsShift;
+        word = (word & ~(entryMask << shift)) | (static_cast<uint64_t>(entry) << shift);
+    }
+
+    uint16_t getOrAddPaletteEntry(Blocks id) {
+        uint16_t entry = lookup[static_cast<int>(id)];
+        if (entry != NO_ENTRY) return entry;
+
+        if (palette.size() >= (size_t(1) << bitsPerEntry)) {
+            compactPalette();
+        }
+        if (palette.size() >= (size_t(1) << bitsPerEntry)) {
+            resize(bitsPerEntry == 0 ? 1 : bitsPerEntry * 2);
+        }
+
+        entry = static_cast<uint16_t>(palette.size());
+        palette.push_back(id);
+        paletteRefs.push_back(0);
+        lookup[static_cast<int>(id)] = entry;
+        return entry;
+    }
+
+    // Drops palette entries no voxel references any more and renumbers the rest.
+    void compactPalette() {
+        if (bitsPerEntry == 0) return;
+
+        std::vector<uint16_t> remap(palette.size(), NO_ENTRY);
+        std::vector<Blocks> newPalette;
+        std::vector<uint32_t> newRefs;
+
+        for (size_t i = 0; i < palette.size(); ++i) {
+            if (paletteRefs[i] == 0) continue;
+            remap[i] = static_cast<uint16_t>(newPalette.size());
+            newPalette.push_back(palette[i]);
+            newRefs.push_back(paletteRefs[i]);
+        }
+        if (newPalette.size() == palette.size()) return;
+
+        for (int i = 0; i < VOLUME; ++i) {
+            writeIndex(i, remap[getPaletteIndex(i)]);
+        }
+
+        palette = std::move(newPalette);
+        paletteRefs = std::move(newRefs);
+        lookup.fill(NO_ENTRY);
+        for (size_t i = 0; i < palette.size(); ++i) {
+            lookup[static_cast<int>(palette[i])] = static_cast<uint16_t>(i);
+        }
+    }
+
+    void resize(int newBits) {
+        assert(newBits <= MAX_BITS);
+        std::vector<uint64_t> newData(wordCount(newBits), 0);
+
+        const int newPerWord = 64 / newBits;
+        for (int i = 0; i < VOLUME; ++i) {
+            uint64_t entry = getPaletteIndex(i);
+            newData[i / newPerWord] |= entry << ((i % newPerWord) * newBits);
+        }
+
+        data = std::move(newData);
+        setBitsPerEntry(newBits);
+    }
+};
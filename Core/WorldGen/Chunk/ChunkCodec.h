@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include "Blocks.h"
+#include "ChunkBlockStorage.h"
+
+// Part of stb_image_write's implementation but missing from its header
+STBIWDEF unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+// Chunk payload encoding, independent of where the bytes are stored.
+//
+// A single 0 byte is an all-air chunk. Otherwise the payload starts with a
+// uint32 version.
+//
+// Version 2:
+//   u32 version | u8 flags | body, or u32 body size + zlib(body) with FLAG_ZLIB
+//   body: u16 palette size | u16 block id per entry | u8 encoding
+//         ENCODING_UNIFORM: nothing
+//         ENCODING_RUNS:    u32 run count | (u16 entry, u16 length - 1) per run
+//         ENCODING_PACKED:  u8 bits | u64 words, same layout as ChunkBlockStorage
+//         u32 property count | (u16 voxel index, u32 size, bytes) per property
+// Only per-instance blocks carry properties, stateless ones get theirs from BlockFactory.
+//
+// Version 3, changes over generated terrain:
+//   u32 version | u8 flags | u32 generator version | u64 seed | body, zlib as in v2
+//   body: u32 change count | (u16 voxel index, u16 block id) per change
+//         properties as in v2
+// The reader regenerates the chunk with the world's generator and applies the changes.
+//
+// Version 1 (read only): per voxel u32 id, and for non-air a u32 size plus properties.
+struct DecodedChunk {
+    ChunkBlockStorage blocks;
+    std::vector<std::pair<int, std::string>> blockProperties;
+
+    // Version 3 only; blocks is left all air and the caller applies changes to generated terrain
+    bool isDiff = false;
+    uint32_t generatorVersion = 0;
+    uint64_t seed = 0;
+    std::vector<std::pair<uint16_t, Blocks>> changes;
+};
+
+class ChunkCodec {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr uint32_t VERSION_DIFF = 3;
+    static constexpr uint8_t FLAG_ZLIB = 1;
+
+    static std::string encode(const ChunkBlockStorage& blocks,
+                              const std::vector<std::pair<int, std::string>>& blockProperties,
+                              bool compress) {
+        std::string out;
+        if (blocks.isUniform() && blocks.getUniformBlock() == Blocks::Air && blockProperties.empty()) {
+            out.push_back('\0');
+            return out;
+        }
+
+        put<uint32_t>(out, VERSION);
+        const size_t flagsPos = out.size();
+        put<uint8_t>(out, 0);
+        const size_t bodyStart = out.size();
+        encodeBody(out, blocks, blockProperties);
+
+        if (compress) deflateBody(out, flagsPos, bodyStart);
+        return out;
+    }
+
+    // Version 3 payload of the voxels where blocks differs from base, the chunk the
+    // generator produces. Empty when nothing differs and there are no properties:
+    // such a chunk needs no save at all.
+    static std::string encodeDiff(const ChunkBlockStorage& blocks, const ChunkBlockStorage& base,
+                                  const std::vector<std::pair<int, std::string>>& blockProperties,
+                                  uint32_t generatorVersion, uint64_t seed, bool compress) {
+        std::vector<std::pair<uint16_t, Blocks>> changes;
+        diff(blocks, base, changes);
+
+        std::string out;
+        const bool hasProperties = std::any_of(blockProperties.begin(), blockProperties.end(),
+            [](const auto& entry) { return !entry.second.empty(); });
+        if (changes.empty() && !hasProperties) return out;
+
+        put<uint32_t>(out, VERSION_DIFF);
+        const size_t flagsPos = out.size();
+        put<uint8_t>(out, 0);
+        put<uint32_t>(out, generatorVersion);
+        put<uint64_t>(out, seed);
+        const size_t bodyStart = out.size();
+
+        put<uint32_t>(out, static_cast<uint32_t>(changes.size()));
+        for (const auto& [idx, id] : changes) {
+            put<uint16_t>(out, idx);
+            put<uint16_t>(out, static_cast<uint16_t>(id));
+        }
+        encodeProperties(out, blockProperties);
+
+        if (compress) deflateBody(out, flagsPos, bodyStart);
+        return out;
+    }
+
+    // Voxels of blocks that differ from base, in index order
+    static void diff(const ChunkBlockStorage& blocks, const ChunkBlockStorage& base,
+                     std::vector<std::pair<uint16_t, Blocks>>& changes) {
+        changes.clear();
+        const int bits = blocks.getBitsPerEntry();
+
+        // Same palette and width: equal words hold equal voxels, only differing words are unpacked
+        if (bits != 0 && bits == base.getBitsPerEntry() && blocks.getPalette() == base.getPalette()) {
+            const auto& words = blocks.getPackedData();
+            const auto& baseWords = base.getPackedData();
+            const int perWord = 64 / bits;
+            for (size_t w = 0; w < words.size(); ++w) {
+                if (words[w] == baseWords[w]) continue;
+                for (int i = static_cast<int>(w) * perWord, end = i + perWord; i < end; ++i) {
+                    if (blocks.getPaletteIndex(i) != base.getPaletteIndex(i)) {
+                        changes.emplace_back(static_cast<uint16_t>(i), blocks.get(i));
+                    }
+                }
+            }
+            return;
+        }
+
+        if (blocks.isUniform() && base.isUniform()) {
+            if (blocks.getUniformBlock() == base.getUniformBlock()) return;
+        }
+        for (int i = 0; i < VOLUME; ++i) {
+            const Blocks id = blocks.get(i);
+            if (id != base.get(i)) changes.emplace_back(static_cast<uint16_t>(i), id);
+        }
+    }
+
+    // False when the payload is truncated, has an unknown version or names an unknown block
+    static bool decode(const char* data, size_t size, DecodedChunk& out) {
+        out.blockProperties.clear();
+        out.changes.clear();
+        out.isDiff = false;
+        if (size == 0) return false;
+        if (data[0] == 0) {
+            out.blocks.fill(Blocks::Air);
+            return true;
+        }
+
+        Reader reader{ data, size };
+        uint32_t version = 0;
+        if (!reader.take(version)) return false;
+
+        if (version == 1) return decodeV1(reader, out);
+        if (version != VERSION && version != VERSION_DIFF) return false;
+
+        uint8_t flags = 0;
+        if (!reader.take(flags)) return false;
+
+        if (version == VERSION) {
+            return readBody(reader, flags, [&](Reader& body) { return decodeBody(body, out); });
+        }
+
+        out.isDiff = true;
+        out.blocks.fill(Blocks::Air);
+        if (!reader.take(out.generatorVersion) || !reader.take(out.seed)) return false;
+        return readBody(reader, flags, [&](Reader& body) { return decodeDiffBody(body, out); });
+    }
+
+private:
+    static constexpr uint8_t ENCODING_UNIFORM = 0;
+    static constexpr uint8_t ENCODING_RUNS = 1;
+    static constexpr uint8_t ENCODING_PACKED = 2;
+    static constexpr int ZLIB_QUALITY = 5;
+    static constexpr int VOLUME = ChunkBlockStorage::VOLUME;
+    // Property bytes per voxel a body is allowed on average; real ones are a few dozen
+    static constexpr size_t PROPERTY_BYTES_PER_VOXEL = 1024;
+    // Largest v2 or v3 body: a full palette and one run per voxel (longer than packed
+    // indices or a full change list), then a property on every voxel
+    static constexpr size_t MAX_BODY_SIZE =
+        (2 + 2 * 0xFFFF + 1) + (4 + 4 * static_cast<size_t>(VOLUME)) +
+        4 + static_cast<size_t>(VOLUME) * (2 + 4 + PROPERTY_BYTES_PER_VOXEL);
+
+    struct Reader {
+        const char* data;
+        size_t size;
+        size_t offset = 0;
+
+        template<typename T>
+        bool take(T& value) {
+            if (size - offset < sizeof(T)) return false;
+            std::memcpy(&value, data + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        bool takeBytes(std::string& value, size_t count) {
+            if (size - offset < count) return false;
+            value.assign(data + offset, count);
+            offset += count;
+            return true;
+        }
+    };
+
+    template<typename T>
+    static void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static bool isKnownBlock(uint32_t id) {
+        return id < static_cast<uint32_t>(Blocks::Count);
+    }
+
+    static void encodeBody(std::string& out, const ChunkBlockStorage& blocks,
+                           const std::vector<std::pair<int, std::string>>& blockProperties) {
+        // Storage palettes may hold entries no voxel uses any more, write only live ones
+        const auto& palette = blocks.getPalette();
+        const auto& refs = blocks.getPaletteRefs();
+        std::vector<uint16_t> remap(palette.size(), 0);
+        std::vector<Blocks> livePalette;
+        for (size_t i = 0; i < palette.size(); ++i) {
+            if (refs[i] == 0) continue;
+            remap[i] = static_cast<uint16_t>(livePalette.size());
+            livePalette.push_back(palette[i]);
+        }
+
+        put<uint16_t>(out, static_cast<uint16_t>(livePalette.size()));
+        for (Blocks id : livePalette) {
+            put<uint16_t>(out, static_cast<uint16_t>(id));
+        }
+
+        if (livePalette.size() == 1) {
+            put<uint8_t>(out, ENCODING_UNIFORM);
+        } else {
+            std::vector<uint32_t> runs;
+            uint16_t runEntry = remap[blocks.getPaletteIndex(0)];
+            uint32_t runLength = 0;
+            for (int i = 0; i < VOLUME; ++i) {
+                const uint16_t entry = remap[blocks.getPaletteIndex(i)];
+                if (entry != runEntry || runLength == 0x10000) {
+                    runs.push_back(runEntry | ((runLength - 1) << 16));
+                    runEntry = entry;
+                    runLength = 0;
+                }
+                ++runLength;
+            }
+            runs.push_back(runEntry | ((runLength - 1) << 16));
+
+            int bits = 1;
+            while ((size_t(1) << bits) < livePalette.size()) bits *= 2;
+            const size_t packedBytes = static_cast<size_t>(VOLUME) * bits / 8;
+
+            if (runs.size() * sizeof(uint32_t) <= packedBytes) {
+                put<uint8_t>(out, ENCODING_RUNS);
+                put<uint32_t>(out, static_cast<uint32_t>(runs.size()));
+                out.append(reinterpret_cast<const char*>(runs.data()), runs.size() * sizeof(uint32_t));
+            } else {
+                put<uint8_t>(out, ENCODING_PACKED);
+                put<uint8_t>(out, static_cast<uint8_t>(bits));
+                const int perWord = 64 / bits;
+                std::vector<uint64_t> words(VOLUME / perWord, 0);
+                for (int i = 0; i < VOLUME; ++i) {
+                    words[i / perWord] |= static_cast<uint64_t>(remap[blocks.getPaletteIndex(i)]) << ((i % perWord) * bits);
+                }
+                out.append(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint64_t));
+            }
+        }
+
+        encodeProperties(out, blockProperties);
+    }
+
+    static void encodeProperties(std::string& out, const std::vector<std::pair<int, std::string>>& blockProperties) {
+        uint32_t propsCount = 0;
+        for (const auto& [idx, props] : blockProperties) {
+            propsCount += props.empty() ? 0 : 1;
+        }
+        put<uint32_t>(out, propsCount);
+        for (const auto& [idx, props] : blockProperties) {
+            if (props.empty()) continue;
+            put<uint16_t>(out, static_cast<uint16_t>(idx));
+            put<uint32_t>(out, static_cast<uint32_t>(props.size()));
+            out.append(props);
+        }
+    }
+
+    // Replaces everything from bodyStart on with u32 body size + zlib(body) and sets
+    // FLAG_ZLIB; leaves the body as is when compression fails
+    static void deflateBody(std::string& out, size_t flagsPos, size_t bodyStart) {
+        int compressedSize = 0;
+        const int bodySize = static_cast<int>(out.size() - bodyStart);
+        unsigned char* compressed = stbi_zlib_compress(
+            reinterpret_cast<unsigned char*>(&out[bodyStart]), bodySize, &compressedSize, ZLIB_QUALITY);
+        if (!compressed) return;
+
+        out.resize(bodyStart);
+        put<uint32_t>(out, static_cast<uint32_t>(bodySize));
+        out.append(reinterpret_cast<const char*>(compressed), static_cast<size_t>(compressedSize));
+        std::free(compressed);
+        out[flagsPos] = static_cast<char>(FLAG_ZLIB);
+    }
+
+    // Runs decode on the body, inflated first when flags has FLAG_ZLIB. The announced size
+    // is checked against MAX_BODY_SIZE and inflating stops there, so a corrupt header or a
+    // crafted stream cannot make the reader allocate more.
+    template<typename Fn>
+    static bool readBody(Reader& reader, uint8_t flags, Fn&& decode) {
+        if (!(flags & FLAG_ZLIB)) return decode(reader);
+
+        uint32_t bodySize = 0;
+        if (!reader.take(bodySize) || bodySize == 0 || bodySize > MAX_BODY_SIZE) return false;
+        std::vector<char> body(bodySize);
+        const int decodedSize = stbi_zlib_decode_buffer(body.data(), static_cast<int>(bodySize),
+            reader.data + reader.offset, static_cast<int>(reader.size - reader.offset));
+        if (decodedSize != static_cast<int>(bodySize)) return false;
+
+        Reader bodyReader{ body.data(), body.size() };
+        return decode(bodyReader);
+    }
+
+    static bool decodeBody(Reader& reader, DecodedChunk& out) {
+        uint16_t paletteSize = 0;
+        if (!reader.take(paletteSize) || paletteSize == 0) return false;
+
+        std::vector<Blocks> palette(paletteSize);
+        for (auto& id : palette) {
+            uint16_t raw = 0;
+            if (!reader.take(raw) || !isKnownBlock(raw)) return false;
+            id = static_cast<Blocks>(raw);
+        }
+
+        uint8_t encoding = 0;
+        if (!reader.take(encoding)) return false;
+
+        if (encoding == ENCODING_UNIFORM) {
+            out.blocks.fill(palette[0]);
+        } else {
+            std::vector<uint16_t> indices(VOLUME);
+
+            if (encoding == ENCODING_RUNS) {
+                uint32_t runCount = 0;
+                if (!reader.take(runCount)) return false;
+                size_t voxel = 0;
+                for (uint32_t r = 0; r < runCount; ++r) {
+                    uint32_t run = 0;
+                    if (!reader.take(run)) return false;
+                    const size_t length = (run >> 16) + 1;
+                    if (voxel + length > indices.size()) return false;
+                    std::fill_n(indices.begin() + voxel, length, static_cast<uint16_t>(run & 0xFFFF));
+                    voxel += length;
+                }
+                if (voxel != indices.size()) return false;
+            } else if (encoding == ENCODING_PACKED) {
+                uint8_t bits = 0;
+                if (!reader.take(bits) || (bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16)) return false;
+                const int perWord = 64 / bits;
+                const uint64_t mask = (uint64_t(1) << bits) - 1;
+                for (int w = 0; w < VOLUME / perWord; ++w) {
+                    uint64_t word = 0;
+                    if (!reader.take(word)) return false;
+                    for (int slot = 0; slot < perWord; ++slot) {
+                        indices[w * perWord + slot] = static_cast<uint16_t>((word >> (slot * bits)) & mask);
+                    }
+                }
+            } else {
+                return false;
+            }
+
+            if (!out.blocks.assign(palette, indices)) return false;
+        }
+
+        return decodeProperties(reader, out);
+    }
+
+    static bool decodeDiffBody(Reader& reader, DecodedChunk& out) {
+        uint32_t changeCount = 0;
+        if (!reader.take(changeCount) || changeCount > static_cast<uint32_t>(VOLUME)) return false;
+
+        out.changes.reserve(changeCount);
+        for (uint32_t i = 0; i < changeCount; ++i) {
+            uint16_t idx = 0;
+            uint16_t id = 0;
+            if (!reader.take(idx) || !reader.take(id)) return false;
+            if (idx >= VOLUME || !isKnownBlock(id)) return false;
+            out.changes.emplace_back(idx, static_cast<Blocks>(id));
+        }
+        return decodeProperties(reader, out);
+    }
+
+    static bool decodeProperties(Reader& reader, DecodedChunk& out) {
+        uint32_t propsCount = 0;
+        if (!reader.take(propsCount)) return false;
+        for (uint32_t i = 0; i < propsCount; ++i) {
+            uint16_t idx = 0;
+            uint32_t propsSize = 0;
+            std::string props;
+            if (!reader.take(idx) || !reader.take(propsSize) || !reader.takeBytes(props, propsSize)) return false;
+            if (idx >= VOLUME) return false;
+            out.blockProperties.emplace_back(idx, std::move(props));
+        }
+        return true;
+    }
+
+    static bool decodeV1(Reader& reader, DecodedChunk& out) {
+        uint32_t blocksCount = 0;
+        if (!reader.take(blocksCount) || blocksCount > static_cast<uint32_t>(VOLUME)) return false;
+
+        // Map ids through a small palette so assign() sees indices, like v2 does
+        std::vector<Blocks> palette;
+        std::vector<uint16_t> paletteOf(static_cast<size_t>(Blocks::Count), 0xFFFF);
+        std::vector<uint16_t> indices(VOLUME, 0);
+        palette.push_back(Blocks::Air);
+        paletteOf[static_cast<size_t>(Blocks::Air)] = 0;
+
+        for (uint32_t i = 0; i < blocksCount; ++i) {
+            uint32_t idInt = 0;
+            if (!reader.take(idInt) || !isKnownBlock(idInt)) return false;
+
+            uint16_t& entry = paletteOf[idInt];
+            if (entry == 0xFFFF) {
+                entry = static_cast<uint16_t>(palette.size());
+                palette.push_back(static_cast<Blocks>(idInt));
+            }
+            indices[i] = entry;
+
+            // air does`nt have params
+            if (static_cast<Blocks>(idInt) == Blocks::Air) continue;
+
+            uint32_t propsSize = 0;
+            std::string props;
+            if (!reader.take(propsSize) || !reader.takeBytes(props, propsSize)) return false;
+            // Stateless blocks wrote "{}", which restores nothing
+            if (!props.empty() && props != "{}") {
+                out.blockProperties.emplace_back(static_cast<int>(i), std::move(props));
+            }
+        }
+
+        return out.blocks.assign(palette, indices);
+    }
+};
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <unordered_set>
+#include <vector>
 #include <mutex>
+#include <thread>
 
 #include "ChunkPos.h"
 #include "ChunkPosHash.h"
@@ -14,7 +17,11 @@
 #include "BlockPos.h"
 #include "ChunkMemoryContainer.h"
 #include "ChunkDataAccess.h"
+#include "BlockEditTransaction.h"
+#include "ChunkSaver.h"
 #include "ThreadPool.h"
+#include "ChunkMeshScheduler.h"
+#include "ChunkUploadScheduler.h"
 #include "Logger.h"
 #include "EventBus.h"
 #include "ChunkSavedEvent.h"
@@ -28,23 +35,33 @@ public:
           _chunkDataAccess(std::make_unique<ChunkDataAccess>()) {}
 
     // === Chunk Access ===
-    std::optional<std::reference_wrapper<Chunk>> getChunk(const ChunkPos& pos) const;
+    // For block access: stamps the chunk's access clock and unparks it first. Main thread only.
+    std::optional<std::reference_wrapper<Chunk>> getChunk(const ChunkPos& pos);
+    // Leaves a parked chunk parked, for what needs no blocks (mesh, render, save state)
+    std::optional<std::reference_wrapper<Chunk>> findChunk(const ChunkPos& pos) const;
     bool hasChunk(const ChunkPos& pos) const;
 
     // === Block Operations ===
     void setBlock(const BlockPos& pos, Blocks id);
-    std::optional<std::reference_wrapper<Block>> getBlock(const BlockPos& pos) const;
+    std::optional<std::reference_wrapper<const Block>> getBlock(const BlockPos& pos);
     void breakBlock(const BlockPos& pos);
 
+    // Groups many edits so each touched chunk is remeshed and saved once, see BlockEditTransaction
+    BlockEditTransaction beginEdit();
+
     // === Update & Render ===
+    // Hands dirty meshes to ChunkMeshScheduler and finished ones to ChunkUploadScheduler, then draws
     void renderAllChunks(Shader& shader, const glm::vec3& sunDirection, const glm::vec3& sunColor);
     void renderChunk(const ChunkPos& pos, Shader& shader, const glm::vec3& sunDirection, const glm::vec3& sunColor);
-    void markChunkDirty(const ChunkPos& pos);
+    void markChunkDirty(const ChunkPos& pos, bool urgent = false);
     void updateChunk(const ChunkPos& pos, float deltaTime);
     void update(const glm::ivec3& playerPos, int viewDistance);
+    // Rebuilds every loaded mesh when next drawn, after a change to how meshes are built
+    void remeshAll();
 
     // === Utility ===
     ChunkPos toChunkPos(const glm::ivec3& pos) const;
+    std::pair<ChunkPos, BlockPos> toChunkLocal(const BlockPos& worldPos) const;
     const std::unique_ptr<ChunkDataAccess>& getChunkDataAccess() const {
         return _chunkDataAccess;
     }
@@ -55,10 +72,53 @@ public:
 
     void initWorld(glm::vec3 playerPos, int viewDistance);
 
+    // === Saving ===
+    // Writes every dirty loaded chunk and every snapshot ChunkSaver failed to write, spread
+    // over the ThreadPool workers, and returns once all are synced to the disk, each payload
+    // before the region entry that points at it. Blocks the calling thread, which also runs
+    // onProgress(done, total). Returns the number of chunks that failed to save; those not
+    // left dirty go back to ChunkSaver.
+    size_t checkpoint(const std::function<void(size_t, size_t)>& onProgress = {});
+
+    // One slice of an autosave: looks at up to AUTOSAVE_CHUNKS_PER_STEP loaded chunks and
+    // hands the dirty ones to ChunkSaver, so a frame pays a bounded cost. True once the
+    // pass over all chunks loaded at its start is complete.
+    bool autosaveStep();
+
+    static constexpr size_t AUTOSAVE_CHUNKS_PER_STEP = 256;
+
+    // === Residency ===
+    // Brings a parked chunk's blocks back, see Chunk::park
+    void unpark(Chunk& chunk);
+
+    // One slice of the residency pass: looks at up to PARK_CHUNKS_PER_STEP loaded chunks and
+    // parks the clean ones further than PARK_MIN_DISTANCE from the center that no block access
+    // touched for PARK_IDLE_TICKS updates. Resident block data follows the working set,
+    // not the view distance.
+    void parkIdleChunks(const ChunkPos& center);
+
+    static constexpr size_t PARK_CHUNKS_PER_STEP = 256;
+    static constexpr uint32_t PARK_IDLE_TICKS = 600;
+    static constexpr int PARK_MIN_DISTANCE = 2;
+
+    // Edited chunks this close to the player (in chunks, per axis) are remeshed in the same frame
+    static constexpr int MESH_PRIORITY_DISTANCE = 1;
+
 private:
+    friend class BlockEditTransaction;
+    // Returns the number of edits that changed a block; edits of chunks that are not loaded are dropped
+    size_t applyEdits(const std::unordered_map<ChunkPos, std::vector<std::pair<BlockPos, Blocks>>>& edits);
+
+    // What getChunk does to the chunk it hands out
+    Chunk& makeResident(Chunk& chunk);
+
     glm::ivec3 worldToChunk(const glm::ivec3& worldPos) const;
+    void updateMeshes(const std::vector<ChunkPos>& chunkPositions);
+    void remeshNeighborsOfInserted();
 
     std::string worldName;
+    // Chunks are only handed out to the thread that created the controller
+    std::thread::id _mainThread = std::this_thread::get_id();
 
     std::unique_ptr<ChunkMemoryContainer> _chunkMemoryContainer;
     std::unique_ptr<ChunkDataAccess> _chunkDataAccess;
@@ -67,4 +127,9 @@ private:
     std::mutex _loadingMutex;
 
     std::optional<ChunkPos> _lastCenter;
+
+    // Chunks the running autosave pass has not looked at yet
+    std::vector<ChunkPos> _autosaveQueue;
+    // Chunks the running residency pass has not looked at yet
+    std::vector<ChunkPos> _parkQueue;
 };
@@ -1,119 +1,172 @@
 #pragma once
 
 #include <string>
-#include <sstream>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
+#include "BlockFactory.h"
 #include "Chunk.h"
+#include "ChunkPool.h"
+#include "ChunkSaver.h"
 #include "ChunkPos.h"
-#include "FileHandler.h"
-#include "PathProvider.h"
+#include "ChunkSnapshot.h"
+#include "ChunkCodec.h"
+#include "ChunkStorageCache.h"
+#include "ChunkGeneratorRegistry.h"
+#include "RegionStorage.h"
+#include "Logger.h"
 #include "ScopedTimer.h"
 
 class ChunkDataAccess {
 public:
-    bool saveChunkToDisk(const ChunkPos& pos, const Chunk& chunk, const std::string& worldName) {
-        auto& fileHandler = FileHandler::getInstance();
-        fs::path chunkFilePath = PathProvider::getInstance().getChunkFilePath(worldName, pos);
-
-        const auto& blocks = chunk.getBlocks();
-
-        bool allAir = std::all_of(blocks.begin(), blocks.end(), [](const auto& b) {
-            return b->getBlockId() == Blocks::Air;
-        });
-
-        std::ofstream ofs(chunkFilePath, std::ios::binary | std::ios::trunc);
-        if (!ofs.is_open()) return false;
+    bool saveChunkToDisk(const Chunk& chunk, const std::string& worldName) {
+        return saveChunkToDisk(chunk.snapshot(), worldName);
+    }
 
-        if (allAir) {
-            uint8_t zero = 0;
-            ofs.write(reinterpret_cast<const char*>(&zero), sizeof(zero));
-            return true;
+    // Reads only the snapshot, safe on a worker while the live chunk keeps changing.
+    // A chunk back to its generated state is removed, the next load regenerates it.
+    // Durable writes are synced to the disk (checkpoints), see RegionFile::write.
+    bool saveChunkToDisk(const ChunkSnapshot& snapshot, const std::string& worldName, bool durable = false) {
+        auto& regions = RegionStorage::getInstance();
+        std::string bytes = serialize(snapshot, worldName);
+        if (bytes.empty()) {
+            return !regions.contains(worldName, snapshot.pos) || regions.erase(worldName, snapshot.pos, durable);
         }
+        return regions.write(worldName, snapshot.pos, bytes, durable);
+    }
 
-        uint32_t version = CHUNK_FILE_VERSION;
-        ofs.write(reinterpret_cast<const char*>(&version), sizeof(version));
-
-        uint32_t blocksCount = static_cast<uint32_t>(blocks.size());
-        ofs.write(reinterpret_cast<const char*>(&blocksCount), sizeof(blocksCount));
-
-        for (const auto& b : blocks) {
-            Blocks id = b->getBlockId();
-            uint32_t idInt = static_cast<uint32_t>(id);
-            ofs.write(reinterpret_cast<const char*>(&idInt), sizeof(idInt));
-
-            // air does`nt have params
-            if (id == Blocks::Air) {
-                continue;
-            }
+    // Saved on disk or waiting in ChunkSaver, answered from memory
+    bool chunkExists(const ChunkPos& pos, const std::string& worldName) {
+        return ChunkSaver::getInstance().hasPending(pos) || RegionStorage::getInstance().contains(worldName, pos);
+    }
 
-            std::string props = b->getBlockProperties();
-            uint32_t propsSize = static_cast<uint32_t>(props.size());
-            ofs.write(reinterpret_cast<const char*>(&propsSize), sizeof(propsSize));
+    std::optional<std::unique_ptr<Chunk>> loadChunkFromDisk(const ChunkPos& pos, const std::string& worldName) {
+        // The region lags behind a save that ChunkSaver has not written yet
+        if (auto pending = ChunkSaver::getInstance().findPending(pos)) {
+            auto chunk = ChunkPool::getInstance().acquire(pos);
+            chunk->restore(*pending);
+            return chunk;
+        }
 
-            if (propsSize > 0) {
-                ofs.write(props.data(), propsSize);
-            }
+        std::unique_ptr<Chunk> chunk;
+        bool found = RegionStorage::getInstance().read(worldName, pos, [&](const char* data, size_t size) {
+            chunk = deserialize(pos, data, size, worldName);
+        });
+        if (!found) return std::nullopt;
+        if (!chunk) {
+            Logger::getInstance().Log("Corrupted chunk data at " + pos.toString(), LogLevel::Warning);
+            return std::nullopt;
         }
+        return chunk;
+    }
 
-        ofs.close();
-        return true;
+    std::string serialize(const ChunkSnapshot& snapshot) const {
+        return ChunkCodec::encode(*snapshot.blocks, snapshot.blockProperties, _compress.load(std::memory_order_relaxed));
     }
 
+    // Only the changes over the world's generated terrain, or the full chunk when that
+    // is smaller (large /fill edits). Empty when the chunk matches its generated terrain.
+    std::string serialize(const ChunkSnapshot& snapshot, const std::string& worldName) const {
+        std::string full = serialize(snapshot);
+        auto generator = ChunkGeneratorRegistry::getInstance().find(worldName);
+        if (!generator) return full;
+
+        auto base = generator->generateChunk(snapshot.pos);
+        std::string diff = ChunkCodec::encodeDiff(*snapshot.blocks, *base, snapshot.blockProperties,
+            generator->getVersion(), generator->getSeed(), _compress.load(std::memory_order_relaxed));
+        return (diff.empty() || diff.size() < full.size()) ? diff : full;
+    }
 
-    std::optional<std::unique_ptr<Chunk>> loadChunkFromDisk(const ChunkPos& pos, const std::string& worldName) {
-        auto& fileHandler = FileHandler::getInstance();
-        fs::path chunkFilePath = PathProvider::getInstance().getChunkFilePath(worldName, pos);
+    // nullptr when the data is truncated, names an unknown block, or holds changes
+    // for a world without generator or over another generator version or seed
+    std::unique_ptr<Chunk> deserialize(const ChunkPos& pos, const char* data, size_t size, const std::string& worldName) const {
+        ChunkSnapshot snapshot;
+        if (!decodeSnapshot(pos, data, size, worldName, snapshot)) return nullptr;
 
-        std::ifstream ifs(chunkFilePath, std::ios::binary);
-        if (!ifs.is_open()) return std::nullopt;
+        auto chunk = ChunkPool::getInstance().acquire(pos);
+        chunk->restore(snapshot);
+        return chunk;
+    }
 
-        char firstByte = 0;
-        ifs.read(&firstByte, 1);
-        if (firstByte == 0) {
-            return std::make_unique<Chunk>(pos);
+    // Block data of a clean chunk as the rest of the game last saw it: the save still
+    // waiting in ChunkSaver, the region payload, or else the generated terrain.
+    // Used to bring a parked chunk back (see Chunk::park).
+    std::shared_ptr<const ChunkBlockStorage> reloadBlocks(const ChunkPos& pos, const std::string& worldName) const {
+        if (auto pending = ChunkSaver::getInstance().findPending(pos)) {
+            return pending->blocks;
         }
 
-        ifs.seekg(0);
-        uint32_t version = 0;
-        ifs.read(reinterpret_cast<char*>(&version), sizeof(version));
-        if (version != CHUNK_FILE_VERSION) throw std::runtime_error("Chunk file version mismatch!");
-
-        uint32_t blocksCount = 0;
-        ifs.read(reinterpret_cast<char*>(&blocksCount), sizeof(blocksCount));
-
-        auto chunk = std::make_unique<Chunk>(pos);
-        std::vector<std::pair<BlockPos, Blocks>> blockChanges;
+        ChunkSnapshot snapshot;
+        bool decoded = false;
+        bool found = RegionStorage::getInstance().read(worldName, pos, [&](const char* data, size_t size) {
+            decoded = decodeSnapshot(pos, data, size, worldName, snapshot);
+        });
+        if (found) {
+            if (!decoded) Logger::getInstance().Log("Corrupted chunk data at " + pos.toString(), LogLevel::Warning);
+            return decoded ? snapshot.blocks : nullptr;
+        }
 
-        for (uint32_t i = 0; i < blocksCount; ++i) {
-            uint32_t idInt = 0;
-            ifs.read(reinterpret_cast<char*>(&idInt), sizeof(idInt));
-            Blocks id = static_cast<Blocks>(idInt);
+        auto generator = ChunkGeneratorRegistry::getInstance().find(worldName);
+        return generator ? generator->generateChunk(pos) : nullptr;
+    }
 
-            std::string props;
+    // Payload back to block data, the same path loads take. False when it does not decode.
+    bool decodeSnapshot(const ChunkPos& pos, const char* data, size_t size, const std::string& worldName,
+                        ChunkSnapshot& snapshot) const {
+        // Identical payloads decode to the same blocks, share the copy a loaded chunk already has
+        const std::string_view payload(data, size);
+        if (auto shared = ChunkStorageCache::getInstance().find(payload)) {
+            snapshot.pos = pos;
+            snapshot.blocks = std::move(shared);
+            return true;
+        }
 
-            if (id != Blocks::Air) {
-                uint32_t propsSize = 0;
-                ifs.read(reinterpret_cast<char*>(&propsSize), sizeof(propsSize));
-                if (propsSize > 0) {
-                    props.resize(propsSize);
-                    ifs.read(&props[0], propsSize);
-                }
+        DecodedChunk decoded;
+        if (!ChunkCodec::decode(data, size, decoded)) return false;
+
+        snapshot.pos = pos;
+        snapshot.blockProperties = std::move(decoded.blockProperties);
+
+        if (decoded.isDiff) {
+            auto generator = ChunkGeneratorRegistry::getInstance().find(worldName);
+            if (!generator) return false;
+            // The changes only mean something over the terrain they were taken against. Another
+            // generator would change every unedited block around them, and the next save would
+            // make that permanent: refuse the chunk and leave the payload on disk untouched.
+            if (decoded.generatorVersion != generator->getVersion() || decoded.seed != generator->getSeed()) {
+                Logger::getInstance().Log("Chunk " + pos.toString() + " holds changes over generator version " +
+                    std::to_string(decoded.generatorVersion) + ", seed " + std::to_string(decoded.seed) +
+                    "; this world generates version " + std::to_string(generator->getVersion()) + ", seed " +
+                    std::to_string(generator->getSeed()) + ". Not loaded.", LogLevel::Error);
+                return false;
             }
-
-            int x = i % Chunk::CHUNK_SIZE;
-            int y = (i / Chunk::CHUNK_SIZE) % Chunk::CHUNK_SIZE;
-            int z = i / (Chunk::CHUNK_SIZE * Chunk::CHUNK_SIZE);
-            BlockPos blockPos{ glm::ivec3(x, y, z) };
-
-            blockChanges.emplace_back(blockPos, id);
-
-            chunk->getBlockPtr(blockPos)->setBlockProperties(props);
+            auto blocks = generator->generateChunk(pos);
+            for (const auto& [idx, id] : decoded.changes) {
+                blocks->set(idx, id);
+            }
+            snapshot.blocks = std::move(blocks);
+        } else {
+            auto blocks = std::make_shared<const ChunkBlockStorage>(std::move(decoded.blocks));
+            // Stateless blocks take theirs from BlockFactory (older saves wrote them too); dropped,
+            // they no longer keep the chunk from being shared
+            auto& factory = BlockFactory::getInstance();
+            std::erase_if(snapshot.blockProperties, [&](const auto& entry) {
+                return factory.isShared(blocks->get(entry.first));
+            });
+            if (snapshot.blockProperties.empty()) {
+                ChunkStorageCache::getInstance().insert(payload, blocks);
+            }
+            snapshot.blocks = std::move(blocks);
         }
+        return true;
+    }
 
-        chunk->setBlocks(blockChanges);
-        return chunk;
+    // Deflate stage on top of the run-length / bit-packed encoding, off by default
+    static void setCompression(bool enabled) {
+        _compress.store(enabled, std::memory_order_relaxed);
     }
 
 private:
-    static constexpr uint32_t CHUNK_FILE_VERSION = 1;
+    static inline std::atomic<bool> _compress{false};
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "IChunkGenerator.h"
+
+// Generator of each open world, by world name. Lets ChunkLoader and ChunkSaver
+// regenerate a chunk's base terrain knowing only the world it belongs to.
+class ChunkGeneratorRegistry {
+public:
+    static ChunkGeneratorRegistry& getInstance() {
+        static ChunkGeneratorRegistry instance;
+        return instance;
+    }
+
+    void set(const std::string& worldName, std::shared_ptr<const IChunkGenerator> generator) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _generators[worldName] = std::move(generator);
+    }
+
+    // nullptr when the world has none: chunks are then saved in full and generate as air
+    std::shared_ptr<const IChunkGenerator> find(const std::string& worldName) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _generators.find(worldName);
+        return it != _generators.end() ? it->second : nullptr;
+    }
+
+private:
+    ChunkGeneratorRegistry() = default;
+    ~ChunkGeneratorRegistry() = default;
+
+    ChunkGeneratorRegistry(const ChunkGeneratorRegistry&) = delete;
+    ChunkGeneratorRegistry& operator=(const ChunkGeneratorRegistry&) = delete;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, std::shared_ptr<const IChunkGenerator>> _generators;
+};
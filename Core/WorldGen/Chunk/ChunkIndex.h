@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkPos.h"
+#include "RegionFile.h"
+
+namespace fs = std::filesystem;
+
+// Positions of every chunk saved in one world, one bit per chunk grouped by
+// region, so existence checks never touch the file system.
+// Loaded from the world's index file, or rebuilt from the region file headers
+// when that file is missing. The file is removed on the first change and
+// written back by save(), a crash in between leads to a rebuild, never to a
+// stale index.
+class ChunkIndex {
+public:
+    explicit ChunkIndex(const std::string& worldName);
+
+    bool contains(const ChunkPos& pos) const {
+        std::shared_lock lock(_mutex);
+        auto it = _regions.find(ChunkPos(RegionFile::toRegionPos(pos)));
+        if (it == _regions.end()) return false;
+        const int index = RegionFile::toLocalIndex(pos);
+        return (it->second[index >> 6] >> (index & 63)) & 1u;
+    }
+
+    void set(const ChunkPos& pos, bool saved);
+    // Replaces the bits of a whole region, after its file was rewritten or removed
+    void setRegion(const glm::ivec3& regionPos, const RegionFile::PresenceMask& mask);
+
+    size_t size() const {
+        std::shared_lock lock(_mutex);
+        return _count;
+    }
+
+    // Every saved chunk, grouped by region
+    std::vector<ChunkPos> getPositions() const {
+        std::shared_lock lock(_mutex);
+        std::vector<ChunkPos> positions;
+        positions.reserve(_count);
+        for (const auto& [regionPos, mask] : _regions) {
+            const glm::ivec3 origin = regionPos.position * RegionFile::REGION_SIZE;
+            for (int index = 0; index < RegionFile::CHUNK_COUNT; ++index) {
+                if (!((mask[index >> 6] >> (index & 63)) & 1u)) continue;
+                positions.emplace_back(origin + glm::ivec3(index % RegionFile::REGION_SIZE,
+                    (index / RegionFile::REGION_SIZE) % RegionFile::REGION_SIZE,
+                    index / (RegionFile::REGION_SIZE * RegionFile::REGION_SIZE)));
+            }
+        }
+        return positions;
+    }
+
+    bool save();
+
+private:
+    bool load();
+    void rebuild();
+
+    fs::path _path;
+    fs::path _regionsPath;
+    mutable std::shared_mutex _mutex;
+    // Keyed by region position
+    std::unordered_map<ChunkPos, RegionFile::PresenceMask> _regions;
+    size_t _count = 0;
+    bool _fileCurrent = false;
+};
@@ -5,6 +5,7 @@
 #include <unordered_set>
 #include <vector>
 #include <functional>
+#include <future>
 #include <shared_mutex>
 #include <optional>
 #include <mutex>
@@ -13,15 +14,20 @@
 #include "Chunk.h"
 #include "ChunkPos.h"
 #include "ChunkLoader.h"
+#include "ChunkPool.h"
 #include "Logger.h"
 #include "FileHandler.h"
 #include "PathProvider.h"
 #include "ThreadPool.h"
+#include "ChunkSaver.h"
+#include "AsyncFileIO.h"
+#include "RegionStorage.h"
 
 class ChunkMemoryContainer {
 public:
     ChunkMemoryContainer() = default;
-    ~ChunkMemoryContainer() = default;
+    // Read callbacks point at this container
+    ~ChunkMemoryContainer() { AsyncFileIO::getInstance().drain(); }
 
     // === Chunk Access ===
     std::optional<std::reference_wrapper<Chunk>> getChunk(const ChunkPos& pos) const;
@@ -47,12 +53,54 @@ public:
 
     void loadInitialChunksBlocking(const std::vector<ChunkPos>& chunksPos, const std::string& worldName);
 
+    // Chunks inserted by loader threads since the last call, for neighbour remeshing on the main thread
+    std::vector<ChunkPos> takeInsertedChunks();
+
+    // Hands payloads read by AsyncFileIO since the last call to the ThreadPool for decoding.
+    // Main thread only: the ThreadPool queue has a single producer.
+    void dispatchCompletedReads();
+
 private:
+    struct CompletedRead {
+        ChunkPos pos;
+        std::string worldName;
+        bool ok = false;
+        std::string bytes;
+    };
+
+    // Chunks handed to the ThreadPool in one task: position, stored on disk
+    using LoadBatch = std::vector<std::pair<ChunkPos, bool>>;
+
+    // A task out on the ThreadPool. A full queue drops its oldest task unrun, which breaks
+    // the future; the batch is then queued again (see reapLoadTasks).
+    struct LoadTask {
+        std::future<void> done;
+        LoadBatch batch;
+        std::string worldName;
+    };
+
+    // Inserts a chunk built by a loader thread and clears its loading mark; nullptr only clears
+    void finishLoading(const ChunkPos& pos, std::unique_ptr<Chunk> chunk);
+    // Loads or generates every chunk of batch, on the calling thread
+    void loadBatch(const LoadBatch& batch, const std::string& worldName);
+    // Main thread: queues work for the chunks of batch on the ThreadPool and keeps the task
+    // until it has run
+    void enqueueLoadTask(std::function<void()> work, LoadBatch batch, const std::string& worldName);
+    // Main thread: forgets tasks that ran, queues the batches of dropped ones again
+    void reapLoadTasks();
+
     mutable std::shared_mutex _mutex;
     std::mutex _loadingMutex;
 
     std::unordered_map<ChunkPos, std::unique_ptr<Chunk>> _chunks;
     std::unordered_set<ChunkPos> _loadingSet;
+    std::vector<ChunkPos> _inserted;
+
+    std::mutex _readsMutex;
+    std::vector<CompletedRead> _completedReads;
+
+    // Main thread only
+    std::vector<LoadTask> _loadTasks;
 
     ChunkLoader _chunkLoader;
     std::function<void(std::unique_ptr<Chunk>)> _saveCallback;
@@ -22,10 +22,17 @@ struct ChunkMesh
 
     GLsizei vertexCount = 0;
     GLsizei indexCount = 0;
+    // Allocated buffer sizes, staged uploads reuse them while the mesh fits
+    GLsizeiptr vboCapacity = 0;
+    GLsizeiptr eboCapacity = 0;
 
     bool isUploaded = true;
     bool needUpdate = false;
+    // Set by edits: the rebuild may take ChunkMeshScheduler's priority lane
+    bool urgent = false;
     bool texturesBound = false;
+    // Ticket of the job building this mesh, 0 while none is out
+    uint64_t jobTicket = 0;
     Chunk& chunk;
 
     ChunkMesh(Chunk& chunk)
@@ -41,9 +48,10 @@ struct ChunkMesh
     void uploadToGPU() {
         if (isUploaded) return;
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        // Buffer names are created once and reused for every later upload, also after the chunk is recycled
+        if (VAO == 0) {
+            createBuffers();
+        }
 
         glBindVertexArray(VAO);
 
@@ -53,55 +61,118 @@ struct ChunkMesh
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshBuilder.indices.size() * sizeof(unsigned int), meshBuilder.indices.data(), GL_STATIC_DRAW);
 
-        constexpr GLuint posAttrib = 0;
-        constexpr GLuint normalAttrib = 1;
-        constexpr GLuint texCoordAttrib = 2;
-        constexpr GLuint textureIDAttrib = 3;
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glEnableVertexAttribArray(posAttrib);
-        glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        vertexCount = static_cast<GLsizei>(meshBuilder.vertices.size());
+        indexCount = static_cast<GLsizei>(meshBuilder.indices.size());
+        vboCapacity = static_cast<GLsizeiptr>(getVertexBytes());
+        eboCapacity = static_cast<GLsizeiptr>(getIndexBytes());
 
-        glEnableVertexAttribArray(normalAttrib);
-        glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        isUploaded = true;
+    }
 
-        glEnableVertexAttribArray(texCoordAttrib);
-        glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    // Same as uploadToGPU from arrays already copied into a staging buffer (see
+    // ChunkUploadScheduler): the GPU copies them, the driver never sees client memory
+    void uploadFromStaging(GLuint staging, GLintptr vertexOffset, GLintptr indexOffset) {
+        if (isUploaded) return;
+        if (VAO == 0) {
+            createBuffers();
+        }
 
-        glBindVertexArray(0);
+        auto copy = [staging](GLuint target, GLsizeiptr& capacity, GLintptr offset, GLsizeiptr bytes) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+            if (bytes > capacity) {
+                // Room to grow, so the next edits of this chunk reuse the allocation
+                capacity = bytes + bytes / 4;
+                glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+            }
+            if (bytes > 0) {
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, bytes);
+            }
+        };
+
+        glBindBuffer(GL_COPY_READ_BUFFER, staging);
+        copy(VBO, vboCapacity, vertexOffset, static_cast<GLsizeiptr>(getVertexBytes()));
+        copy(EBO, eboCapacity, indexOffset, static_cast<GLsizeiptr>(getIndexBytes()));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 
         vertexCount = static_cast<GLsizei>(meshBuilder.vertices.size());
         indexCount = static_cast<GLsizei>(meshBuilder.indices.size());
 
         isUploaded = true;
-        needUpdate = false;
     }
 
-    void update() {
-        if (needUpdate) {
-            meshBuilder.update();
+    size_t getVertexBytes() const { return meshBuilder.vertices.size() * sizeof(Vertex); }
+    size_t getIndexBytes() const { return meshBuilder.indices.size() * sizeof(unsigned int); }
 
-            if (!isUploaded) {
-                uploadToGPU();
-            } else {
-                glBindBuffer(GL_ARRAY_BUFFER, VBO);
-                glBufferData(GL_ARRAY_BUFFER, meshBuilder.vertices.size() * sizeof(Vertex), meshBuilder.vertices.data(), GL_STATIC_DRAW);
+    // Main thread. Turns a pending rebuild into a job for ChunkMeshScheduler; nullptr when
+    // none is pending, a job for this mesh is still out, or the chunk is empty and its
+    // mesh was simply cleared. An urgent rebuild does not wait: its job supersedes the
+    // one out, whose result is then dropped.
+    std::unique_ptr<ChunkMeshJob> takeJob() {
+        if (!needUpdate || (jobTicket != 0 && !urgent)) return nullptr;
 
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshBuilder.indices.size() * sizeof(unsigned int), meshBuilder.indices.data(), GL_STATIC_DRAW);
+        auto job = std::make_unique<ChunkMeshJob>();
+        job->priority = urgent;
+        needUpdate = false;
+        urgent = false;
+        if (!meshBuilder.prepare(*job)) {
+            // Nothing to draw: no GL calls, buffers already created are kept for later meshes
+            jobTicket = 0;
+            meshBuilder.clear();
+            vertexCount = 0;
+            indexCount = 0;
+            isUploaded = true;
+            return nullptr;
+        }
+        job->ticket = jobTicket = nextJobTicket++;
+        return job;
+    }
 
-                vertexCount = static_cast<GLsizei>(meshBuilder.vertices.size());
-                indexCount = static_cast<GLsizei>(meshBuilder.indices.size());
+    // Main thread. Takes a finished job's mesh, to be uploaded through ChunkUploadScheduler;
+    // false when there is nothing to upload: a job this mesh no longer waits for (the chunk
+    // was recycled meanwhile), or an empty mesh, which is taken without GL calls.
+    bool finishJob(ChunkMeshJob& job) {
+        if (job.ticket != jobTicket) return false;
+        jobTicket = 0;
+        meshBuilder.vertices = std::move(job.vertices);
+        meshBuilder.indices = std::move(job.indices);
+        if (meshBuilder.vertices.empty()) {
+            vertexCount = 0;
+            indexCount = 0;
+            isUploaded = true;
+            return false;
+        }
+        isUploaded = false;
+        return true;
+    }
 
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    bool isBuilding() const { return jobTicket != 0; }
 
-                needUpdate = false;
-            }
-        }
+    // The GPU holds the uploaded mesh, the CPU arrays are only needed again by the next rebuild
+    void releaseCpuCopy() {
+        if (!isUploaded || needUpdate || jobTicket != 0) return;
+        std::vector<Vertex>().swap(meshBuilder.vertices);
+        std::vector<unsigned int>().swap(meshBuilder.indices);
+    }
+
+    // Back to an empty mesh for a recycled chunk. CPU capacity and GL names are kept,
+    // a job still out for the old position is dropped when it returns.
+    void reset() {
+        meshBuilder.clear();
+        vertexCount = 0;
+        indexCount = 0;
+        isUploaded = true;
+        needUpdate = false;
+        urgent = false;
+        jobTicket = 0;
     }
 
+    // Draws the last uploaded mesh; rebuilds arrive through ChunkMeshScheduler
     void render(Shader shader, const glm::vec3& sunDirection, const glm::vec3& sunColor) {
-        if (needUpdate) update();
+        if (VAO == 0 || (vertexCount == 0 && indexCount == 0)) return;
         shader.use();
 
         if (!texturesBound) {
@@ -121,4 +192,36 @@ struct ChunkMesh
         glBindVertexArray(0);
     }
 
+private:
+    inline static uint64_t nextJobTicket = 1;
+
+    void createBuffers() {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+        constexpr GLuint posAttrib = 0;
+        constexpr GLuint normalAttrib = 1;
+        constexpr GLuint texCoordAttrib = 2;
+        constexpr GLuint atlasRectAttrib = 3;
+
+        glEnableVertexAttribArray(posAttrib);
+        glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+
+        glEnableVertexAttribArray(normalAttrib);
+        glVertexAttribPointer(normalAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+        glEnableVertexAttribArray(texCoordAttrib);
+        glVertexAttribPointer(texCoordAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+
+        glEnableVertexAttribArray(atlasRectAttrib);
+        glVertexAttribPointer(atlasRectAttrib, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, atlasRect));
+
+        glBindVertexArray(0);
+    }
+
 };
\ No newline at end of file
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -12,17 +15,40 @@
 #include "BlockFace.h"
 #include "PathProvider.h"
 #include "ChunkBlocksOpaqueData.h"
+#include "ChunkBlockStorage.h"
 #include "BlockPos.h"
+#include "ChunkPos.h"
 #include "BlockModelStructs.h"
+#include "ChunkMesher.h"
 
 class Chunk;
-struct AtlasRegion;
+
+// One mesh build with its own copy of everything it reads, so a worker can run it while
+// the chunk is edited, parked or recycled. Filled by ChunkMeshBuilder::prepare on the
+// main thread, built by ChunkMeshBuilder::run on any thread.
+struct ChunkMeshJob {
+    ChunkPos pos;
+    uint64_t ticket = 0;     // matched against the mesh on return, see ChunkMesh::finishJob
+    bool priority = false;   // edit near the player, see ChunkMeshScheduler
+    int distance = 0;        // from the player in chunks, nearer jobs are built first
+    MeshingMode mode = MeshingMode::Greedy;
+
+    std::shared_ptr<const ChunkBlockStorage> blocks;
+    ChunkBlocksOpaqueData opacity;
+    std::array<std::array<uint32_t, ChunkMeshSource::SIZE>, 6> borders{};
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
 
 class ChunkMeshBuilder {
 public:
     explicit ChunkMeshBuilder(Chunk& chunk);
-    void buildMesh();
-    void update();
+    // Main thread. Copies the chunk's blocks (shared until the next edit), opacity and
+    // neighbour borders into the job; false for an empty chunk, which has nothing to build.
+    bool prepare(ChunkMeshJob& job);
+    // Any thread: fills the job's vertices and indices, from ChunkMeshCache when it can
+    static void run(ChunkMeshJob& job);
     void clear();
     size_t getVertexCount() const;
     size_t getIndexCount() const;
@@ -32,19 +58,17 @@ public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
 
+    // Used by every later rebuild, see ChunkController::remeshAll
+    static void setMeshingMode(MeshingMode mode) { meshingMode.store(mode, std::memory_order_relaxed); }
+    static MeshingMode getMeshingMode() { return meshingMode.load(std::memory_order_relaxed); }
+
 private:
     Chunk& chunk;
 
-    bool getOpaqueSafe(glm::ivec3 localPos);
-    void processBlockFace(const glm::ivec3& worldBlockPos,
-                          const BlockModel& model,
-                          const BlockModelElement& element,
-                          const std::string& faceKey);
-    void addQuad(const glm::vec3* quadVerts,
-                 const glm::vec3& normal,
-                 const glm::vec2* quadUVs);
-    glm::vec3 getNormalForFace(const std::string& faceKey);
-    void getFaceVertices(const BlockModelElement& element,
-                         const std::string& faceKey,
-                         glm::vec3 outVerts[4]);
+    inline static std::atomic<MeshingMode> meshingMode{MeshingMode::Greedy};
+
+    // Opacity of the neighbour layers touching the chunk, see ChunkMeshSource::borders
+    void gatherBorders(ChunkMeshJob& job);
+    // ChunkMeshCache key: position, blocks, neighbour border opacity, atlas layout and meshing mode
+    static uint64_t computeCacheKey(const ChunkMeshSource& source, MeshingMode mode);
 };
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkPos.h"
+#include "Vertex.h"
+
+namespace fs = std::filesystem;
+
+struct ChunkMeshCacheStats {
+    size_t lookups = 0;    // load() calls while enabled
+    size_t hits = 0;       // lookups answered from the cache
+    size_t stores = 0;     // meshes handed to store()
+    size_t evictions = 0;  // files removed to stay under MAX_BYTES
+    size_t entries = 0;    // meshes on disk or waiting to be written
+    uint64_t bytes = 0;    // their total file size
+
+    double hitRate() const {
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+    }
+};
+
+// Finished chunk meshes on disk, one file per chunk in the world's meshcache folder
+// next to its regions. Each file is tagged with the key ChunkMeshBuilder derives from
+// everything the mesh depends on (blocks, neighbour borders, block models and opacity,
+// atlas layout); a file with another key is a miss, told from the key kept in memory
+// without reading the file. Files are written by a background thread that keeps
+// only the newest mesh per chunk. The folder is capped at MAX_BYTES, least recently
+// used files go first; recency survives restarts through the file times.
+// Raw vertex layout of this build: the folder is a cache, not a save format.
+class ChunkMeshCache {
+public:
+    static constexpr uint64_t MAX_BYTES = 256ull * 1024 * 1024;
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+    static ChunkMeshCache& getInstance() {
+        static ChunkMeshCache instance;
+        return instance;
+    }
+
+    // Indexes the world's meshcache folder; meshes of the previous world are written first
+    void open(const std::string& worldName);
+
+    // Fills vertices and indices and returns true when a mesh with this key is cached
+    bool load(const ChunkPos& pos, uint64_t key, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+    void store(const ChunkPos& pos, uint64_t key, const std::vector<Vertex>& vertices,
+               const std::vector<unsigned int>& indices);
+
+    // Writes everything queued and stops the writer thread; later stores are dropped
+    void shutdown();
+
+    void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    ChunkMeshCacheStats getStats() const;
+
+private:
+    struct PendingMesh {
+        fs::path path;
+        std::string bytes;
+    };
+
+    struct Entry {
+        std::list<ChunkPos>::iterator lru;
+        uint64_t bytes = 0;
+        uint64_t key = 0;  // of the file, or of the mesh waiting to be written
+    };
+
+    ChunkMeshCache();
+    ~ChunkMeshCache();
+
+    ChunkMeshCache(const ChunkMeshCache&) = delete;
+    ChunkMeshCache& operator=(const ChunkMeshCache&) = delete;
+
+    fs::path pathFor(const ChunkPos& pos) const;
+    static bool parseFileName(const fs::path& path, ChunkPos& pos);
+    // Key from the file header, false for a file of another format
+    static bool readKey(const fs::path& path, uint64_t& key);
+    static std::string encode(uint64_t key, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    static bool decode(const std::string& bytes, uint64_t key, std::vector<Vertex>& vertices,
+                       std::vector<unsigned int>& indices);
+
+    // Caller holds _mutex
+    void touch(const ChunkPos& pos, uint64_t bytes, uint64_t key);
+    void evictOverflow();
+    void waitForWriter(std::unique_lock<std::mutex>& lock);
+
+    void run();
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+
+    std::atomic<bool> _enabled{true};
+    fs::path _folder;
+
+    // Front = most recently used
+    std::list<ChunkPos> _lru;
+    std::unordered_map<ChunkPos, Entry> _entries;
+    uint64_t _bytes = 0;
+
+    std::unordered_map<ChunkPos, PendingMesh> _pending;
+    std::vector<fs::path> _removals;
+    bool _writing = false;
+    bool _stopping = false;
+    ChunkMeshCacheStats _stats;
+
+    std::thread _thread;
+};
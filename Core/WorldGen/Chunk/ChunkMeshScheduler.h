@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ChunkMeshBuilder.h"
+
+struct ChunkMeshSchedulerStats {
+    size_t queued = 0;         // jobs waiting for a worker
+    size_t running = 0;        // jobs being built
+};
+
+// Runs ChunkMeshJobs on the ThreadPool, nearest chunk first. Jobs own their input, so
+// the main thread only prepares them and takes the finished meshes back in collect().
+// Priority jobs (edits near the player) go before all others and are finished by the
+// collect() of the frame that submitted them: the main thread builds those no worker
+// has started and waits for the rest, so a block change is on screen the same frame.
+// Main thread only, apart from the workers it starts; the ThreadPool queue has a single producer.
+class ChunkMeshScheduler {
+public:
+    // How long one ThreadPool task keeps taking jobs before it gives its worker back
+    static constexpr std::chrono::milliseconds RUNNER_TIME_SLICE{4};
+
+    static ChunkMeshScheduler& getInstance() {
+        static ChunkMeshScheduler instance;
+        return instance;
+    }
+
+    void submit(std::unique_ptr<ChunkMeshJob> job);
+
+    // Starts workers for the queued jobs, finishes the priority ones and returns every
+    // job finished since the last call. Stale jobs are for the caller to drop.
+    std::vector<std::unique_ptr<ChunkMeshJob>> collect();
+
+    // Drops queued jobs and waits for the running ones; later submits are dropped too.
+    // Before ChunkMeshCache::shutdown, which running jobs still store into.
+    void shutdown();
+
+    ChunkMeshSchedulerStats getStats() const;
+
+private:
+    ChunkMeshScheduler() = default;
+
+    ChunkMeshScheduler(const ChunkMeshScheduler&) = delete;
+    ChunkMeshScheduler& operator=(const ChunkMeshScheduler&) = delete;
+
+    // Caller holds _mutex. Priority first, then the nearest queued job; nullptr when none.
+    std::unique_ptr<ChunkMeshJob> takeNext(bool priorityOnly);
+    void finish(std::unique_ptr<ChunkMeshJob> job);
+    // Forgets runners that returned; one the full ThreadPool queue pushed out never ran,
+    // its future is broken and its slot in _runnersWaiting is given back
+    void reapRunners();
+    // ThreadPool task body
+    void runQueued();
+
+    mutable std::mutex _mutex;
+    std::condition_variable _priorityDone;
+    std::condition_variable _idle;
+
+    std::vector<std::unique_ptr<ChunkMeshJob>> _priority;
+    // Heap, nearest on top
+    std::vector<std::unique_ptr<ChunkMeshJob>> _queued;
+    std::vector<std::unique_ptr<ChunkMeshJob>> _finished;
+
+    size_t _running = 0;
+    size_t _priorityRunning = 0;
+    // Tasks handed to the ThreadPool that have not started yet
+    size_t _runnersWaiting = 0;
+    // Futures of the tasks handed to the ThreadPool, main thread only
+    std::vector<std::future<void>> _runners;
+    bool _stopping = false;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+#include "ChunkBlockStorage.h"
+#include "ChunkBlocksOpaqueData.h"
+
+enum class MeshingMode {
+    Faces,   // one quad per visible block face
+    Greedy   // coplanar full-cube faces with the same texture merged into larger quads
+};
+
+// Everything a chunk mesh depends on besides block models and the atlas: the chunk's
+// blocks and opacity, and the layer of each neighbour touching it.
+struct ChunkMeshSource {
+    static constexpr int SIZE = ChunkBlockStorage::SIZE;
+
+    glm::ivec3 chunkPos{ 0 };
+    const ChunkBlockStorage* blocks = nullptr;
+    const ChunkBlocksOpaqueData* opacity = nullptr;
+
+    // Opacity of the neighbour blocks touching each face, in BlockFace.h order. Across
+    // an x face borders[face][z] holds bit y, across a y face [z] bit x, across a z face [y] bit x.
+    // All zero where the neighbour is not loaded: its faces are drawn.
+    std::array<std::array<uint32_t, SIZE>, 6> borders{};
+};
+
+// Builds chunk meshes from a ChunkMeshSource alone. Vertex positions are in world space,
+// texCoord counts texture repeats across the quad and atlasRect places the texture in
+// the atlas, the fragment shader wraps one into the other so merged quads tile.
+// Full cubes are culled a row of 32 blocks at a time on opacity bitmasks; only other
+// models are walked block by block. Faces come from BlockCache's baked quads, so
+// BlockCache::bakeModels has to have run.
+class ChunkMesher {
+public:
+    static void build(const ChunkMeshSource& source, MeshingMode mode,
+                      std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+};
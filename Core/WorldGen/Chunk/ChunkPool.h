@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+#include "ChunkPos.h"
+
+class Chunk;
+
+struct ChunkPoolStats {
+    size_t acquired = 0;   // total acquire() calls
+    size_t recycled = 0;   // acquires served from the free list
+    size_t allocated = 0;  // acquires that had to construct a new Chunk
+    size_t inUse = 0;      // chunks handed out and not yet released
+    size_t highWater = 0;  // max inUse seen
+    size_t pooled = 0;     // chunks waiting in the free list
+
+    double recycleRate() const {
+        return acquired == 0 ? 0.0 : static_cast<double>(recycled) / static_cast<double>(acquired);
+    }
+};
+
+// Hands out reset Chunk objects. Released chunks keep their block storage,
+// opacity masks, mesh builder capacity and GL buffer names for the next user.
+class ChunkPool {
+public:
+    static ChunkPool& getInstance() {
+        static ChunkPool instance;
+        return instance;
+    }
+
+    std::unique_ptr<Chunk> acquire(const ChunkPos& pos);
+    void release(std::unique_ptr<Chunk> chunk);
+
+    ChunkPoolStats getStats() const;
+
+    // Chunks beyond this many idle ones are destroyed on release
+    void setMaxPooled(size_t maxPooled);
+
+private:
+    ChunkPool();
+    ~ChunkPool() = default;
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<Chunk>> _free;
+    size_t _maxPooled = 2048;
+    ChunkPoolStats _stats;
+};
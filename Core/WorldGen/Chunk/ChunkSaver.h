@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkPos.h"
+#include "ChunkSnapshot.h"
+
+struct ChunkSaverStats {
+    size_t scheduled = 0;  // schedule() calls
+    size_t coalesced = 0;  // snapshots replaced by a newer one before they were written
+    size_t written = 0;    // chunk files written
+    size_t failed = 0;     // writes that did not reach the final file
+    size_t lost = 0;       // failed snapshots given up at shutdown
+    size_t pending = 0;    // snapshots waiting or being written
+};
+
+// Write-behind persistence. Edits hand over a snapshot and return at once;
+// a background thread keeps only the newest snapshot per chunk and writes
+// them out when the oldest has waited FLUSH_INTERVAL or MAX_PENDING chunks
+// are queued. A snapshot that fails to write is queued again and retried with the
+// next batch, unless a newer one for its chunk has been scheduled meanwhile: the chunk
+// is already marked saved, so the snapshot is the only copy of its edits.
+// Snapshots go into their region file in place (see RegionFile::write) and are not
+// synced: a crash of the game keeps every write that returned, a power loss may lose
+// recent ones or keep a table entry whose payload never reached the disk, so that
+// chunk reads as corrupted.
+// Only checkpoint writes (ChunkController::checkpoint) are synced to the disk.
+class ChunkSaver {
+public:
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{2000};
+    static constexpr size_t MAX_PENDING = 64;
+
+    static ChunkSaver& getInstance() {
+        static ChunkSaver instance;
+        return instance;
+    }
+
+    void schedule(ChunkSnapshot snapshot, const std::string& worldName);
+
+    // Newest unsaved snapshot of a chunk, queued or being written. A loader must
+    // prefer it over the file, which may still hold an older version.
+    std::optional<ChunkSnapshot> findPending(const ChunkPos& pos) const;
+    bool hasPending(const ChunkPos& pos) const;
+
+    // Blocks until everything scheduled so far has been written once. Returns the number
+    // of snapshots that failed and are queued again.
+    size_t flush();
+    // Removes and returns the snapshots of worldName still queued, once no write is in
+    // flight, for a caller that writes them itself (see ChunkController::checkpoint)
+    std::vector<ChunkSnapshot> takePending(const std::string& worldName);
+    // Flushes and stops the writer thread; later schedule() calls write synchronously.
+    // Returns the number of snapshots that could not be written and are lost.
+    size_t shutdown();
+
+    ChunkSaverStats getStats() const;
+
+private:
+    struct PendingSave {
+        ChunkSnapshot snapshot;
+        std::string worldName;
+    };
+
+    ChunkSaver();
+    ~ChunkSaver();
+
+    ChunkSaver(const ChunkSaver&) = delete;
+    ChunkSaver& operator=(const ChunkSaver&) = delete;
+
+    void run();
+    bool write(const PendingSave& save);
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+
+    std::unordered_map<ChunkPos, PendingSave> _pending;
+    // Taken out of _pending by the writer, still visible to findPending until written
+    std::unordered_map<ChunkPos, PendingSave> _inFlight;
+    std::chrono::steady_clock::time_point _oldestPending{};
+    // Failed snapshots queued again by the last batch; they wait for FLUSH_INTERVAL
+    // instead of counting towards MAX_PENDING
+    size_t _requeued = 0;
+    // Batches written so far
+    uint64_t _batches = 0;
+    bool _flushRequested = false;
+    bool _stopping = false;
+    // Writer thread has exited
+    bool _stopped = false;
+    ChunkSaverStats _stats;
+
+    std::thread _thread;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#include "ChunkPos.h"
+#include "ChunkBlockStorage.h"
+
+// Immutable view of a chunk at one edit version. Holding it is cheap: the block
+// storage is shared with the live chunk until the chunk's next write, which
+// copies it first (copy-on-write). Safe to read from any thread.
+struct ChunkSnapshot {
+    ChunkPos pos;
+    uint64_t version = 0;
+    std::shared_ptr<const ChunkBlockStorage> blocks;
+    // Properties of per-instance blocks, copied when the snapshot is taken
+    std::vector<std::pair<int, std::string>> blockProperties;
+
+    bool isEmpty() const {
+        return blocks->isUniform() && blocks->getUniformBlock() == Blocks::Air;
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "ChunkBlockStorage.h"
+
+struct ChunkStorageCacheStats {
+    size_t entries = 0;
+    size_t lookups = 0;
+    size_t hits = 0;
+};
+
+// Decoded block storage by payload bytes, so byte-identical saved chunks loaded at the
+// same time share one immutable copy until their first write (Chunk::editableBlocks copies).
+// Only full payloads of at most MAX_PAYLOAD bytes without block properties are kept:
+// uniform and repeated flat chunks, where sharing pays. The cache holds a reference of
+// its own, so a shared storage never looks unshared to editableBlocks.
+class ChunkStorageCache {
+public:
+    static constexpr size_t MAX_PAYLOAD = 4096;
+    static constexpr size_t MAX_ENTRIES = 1024;
+
+    static ChunkStorageCache& getInstance() {
+        static ChunkStorageCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const ChunkBlockStorage> find(std::string_view payload) {
+        if (payload.size() > MAX_PAYLOAD) return nullptr;
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_lookups;
+        auto it = _entries.find(std::hash<std::string_view>{}(payload));
+        if (it == _entries.end() || it->second.payload != payload) return nullptr;
+        ++_hits;
+        return it->second.blocks;
+    }
+
+    void insert(std::string_view payload, std::shared_ptr<const ChunkBlockStorage> blocks) {
+        if (payload.size() > MAX_PAYLOAD) return;
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_entries.size() >= MAX_ENTRIES) evictUnused();
+        if (_entries.size() >= MAX_ENTRIES) return;
+        _entries.try_emplace(std::hash<std::string_view>{}(payload), Entry{ std::string(payload), std::move(blocks) });
+    }
+
+    ChunkStorageCacheStats getStats() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return ChunkStorageCacheStats{ _entries.size(), _lookups, _hits };
+    }
+
+private:
+    ChunkStorageCache() = default;
+    ~ChunkStorageCache() = default;
+
+    ChunkStorageCache(const ChunkStorageCache&) = delete;
+    ChunkStorageCache& operator=(const ChunkStorageCache&) = delete;
+
+    struct Entry {
+        std::string payload;
+        std::shared_ptr<const ChunkBlockStorage> blocks;
+    };
+
+    // Drops storages no chunk uses any more
+    void evictUnused() {
+        for (auto it = _entries.begin(); it != _entries.end();) {
+            it = it->second.blocks.use_count() == 1 ? _entries.erase(it) : std::next(it);
+        }
+    }
+
+    mutable std::mutex _mutex;
+    std::unordered_map<size_t, Entry> _entries;
+    size_t _lookups = 0;
+    size_t _hits = 0;
+};
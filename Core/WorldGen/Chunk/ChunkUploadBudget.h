@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Which meshes still fit in one frame of ChunkUploadScheduler::process, apart from the GL
+// calls. Meshes are offered in upload order. A non-urgent mesh goes while the frame stays
+// within both budgets, its upload time predicted from the rate measured on earlier
+// uploads; the first mesh of a frame goes whatever its size, urgent meshes always go.
+class ChunkUploadBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ChunkUploadBudget(uint64_t byteBudget, std::chrono::nanoseconds timeBudget)
+        : _byteBudget(byteBudget), _timeBudget(timeBudget) {}
+
+    // Starts counting a frame; the measured rate carries over
+    void beginFrame(Clock::time_point start) {
+        _start = start;
+        _uploads = 0;
+        _bytes = 0;
+    }
+
+    bool admits(uint64_t bytes, bool urgent, Clock::time_point now) const {
+        if (urgent) return true;
+        const auto elapsed = now - _start;
+        if (elapsed > _timeBudget) return false;
+        if (_uploads == 0) return true;
+        const auto predicted = std::chrono::nanoseconds(static_cast<int64_t>(bytes * _nanosPerByte));
+        return _bytes + bytes <= _byteBudget && elapsed + predicted <= _timeBudget;
+    }
+
+    // Counts an upload of bytes that took nanos
+    void record(uint64_t bytes, double nanos) {
+        // Small meshes are mostly call overhead and would make big ones look cheap
+        if (bytes >= MIN_MEASURED_BYTES) {
+            _nanosPerByte = 0.9 * _nanosPerByte + 0.1 * (nanos / bytes);
+        }
+        ++_uploads;
+        _bytes += bytes;
+    }
+
+    size_t getUploads() const { return _uploads; }
+    uint64_t getBytes() const { return _bytes; }
+    double getNanosPerByte() const { return _nanosPerByte; }
+
+    static constexpr uint64_t MIN_MEASURED_BYTES = 64 * 1024;
+
+private:
+    uint64_t _byteBudget;
+    std::chrono::nanoseconds _timeBudget;
+
+    // Measured upload cost, starts pessimistic at 1 GB/s
+    double _nanosPerByte = 1.0;
+
+    Clock::time_point _start{};
+    size_t _uploads = 0;
+    uint64_t _bytes = 0;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "ChunkPos.h"
+#include "ChunkUploadBudget.h"
+
+class Camera;
+class ChunkController;
+
+struct ChunkUploadStats {
+    size_t queued = 0;          // finished meshes waiting for their upload
+    size_t uploads = 0;         // meshes uploaded in the last frame
+    uint64_t bytes = 0;         // their vertex and index bytes
+    double uploadMs = 0.0;      // main thread time spent uploading in the last frame
+    double stallMs = 0.0;       // of which waiting for the GPU to release a staging segment
+    bool stagingRing = false;   // persistently mapped staging ring in use
+};
+
+// Persistently mapped buffer in SEGMENTS parts, one per frame in flight. A frame copies
+// mesh data into its segment and the GPU copies it on into the chunk buffers; the
+// segment is written again only once the fence placed after those copies has passed.
+// Needs glBufferStorage (GL 4.4 or ARB_buffer_storage).
+class StagingRing {
+public:
+    static constexpr int SEGMENTS = 3;
+
+    // False when persistent mapping is not supported; the ring stays unused
+    bool create(size_t segmentBytes);
+    void destroy();
+    bool isReady() const { return mapped != nullptr; }
+
+    // Waits up to maxWait for the GPU to finish with the next segment; false when it has not
+    bool beginFrame(std::chrono::nanoseconds maxWait);
+    // Copies both arrays into the segment and returns their offsets in buffer; false when they do not fit
+    bool stage(const void* first, size_t firstBytes, const void* second, size_t secondBytes,
+               GLintptr& firstOffset, GLintptr& secondOffset);
+    // Fences what this frame staged and moves on to the next segment
+    void endFrame();
+
+    GLuint getBuffer() const { return buffer; }
+    size_t getSegmentBytes() const { return segmentBytes; }
+
+private:
+    GLuint buffer = 0;
+    uint8_t* mapped = nullptr;
+    size_t segmentBytes = 0;
+    int segment = 0;
+    size_t used = 0;       // bytes written into the current segment
+    bool open = false;     // beginFrame succeeded and endFrame has not run yet
+    std::array<GLsync, SEGMENTS> fences{};
+};
+
+// Main-thread queue of finished chunk meshes (see ChunkMesh::finishJob) waiting for their
+// upload. Each frame uploads what fits in FRAME_BYTE_BUDGET and FRAME_TIME_BUDGET (see
+// ChunkUploadBudget): edited chunks near the player first, then chunks in view, nearest
+// first. Urgent meshes (edits) are always uploaded, and a single mesh larger than the
+// whole byte budget goes alone in an otherwise empty frame. Data goes through a
+// StagingRing when the driver supports one, and straight to glBufferData otherwise.
+class ChunkUploadScheduler {
+public:
+    static constexpr uint64_t FRAME_BYTE_BUDGET = 8ull * 1024 * 1024;
+    static constexpr std::chrono::microseconds FRAME_TIME_BUDGET{2000};
+
+    static ChunkUploadScheduler& getInstance() {
+        static ChunkUploadScheduler instance;
+        return instance;
+    }
+
+    // The chunk at pos holds a mesh to upload; urgent for edits near the player
+    void enqueue(const ChunkPos& pos, bool urgent);
+
+    // Once per frame, with the GL context current. camera may be null: distance only.
+    void process(ChunkController& controller, const Camera* camera);
+
+    // Frees the staging ring; before the GL context goes away
+    void shutdown();
+
+    ChunkUploadStats getStats() const;
+
+private:
+    ChunkUploadScheduler() = default;
+
+    ChunkUploadScheduler(const ChunkUploadScheduler&) = delete;
+    ChunkUploadScheduler& operator=(const ChunkUploadScheduler&) = delete;
+
+    // Chunk -> urgent
+    std::unordered_map<ChunkPos, bool> _queued;
+
+    StagingRing _ring;
+    bool _ringTried = false;
+
+    ChunkUploadBudget _budget{ FRAME_BYTE_BUDGET, FRAME_TIME_BUDGET };
+
+    ChunkUploadStats _lastFrame;
+};
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+
 #include "ChunkPos.h"
+#include "ChunkBlockStorage.h"
 
 enum class generationType {
     Flat,
@@ -8,15 +12,22 @@ enum class generationType {
     Custom
 };
 
+// Terrain source of a world. Must be deterministic: the same seed, version and
+// position always give the same blocks, saves only keep the player's changes
+// on top of it (see ChunkCodec::encodeDiff). Loader threads and ChunkSaver call
+// it concurrently.
 class IChunkGenerator {
 public:
     virtual ~IChunkGenerator() = default;
 
-    virtual void generateChunk(const ChunkPos& pos) = 0;
+    virtual std::shared_ptr<ChunkBlockStorage> generateChunk(const ChunkPos& pos) const = 0;
 
     virtual generationType getGeneratorType() const = 0;
 
+    // Bumped whenever generateChunk output changes for any position
+    virtual uint32_t getVersion() const = 0;
+
+    virtual uint64_t getSeed() const = 0;
+
     virtual bool isReady() const = 0;
 };
-
-// For now dont used. Need to realize later.
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkPos.h"
+#include "MappedFile.h"
+
+namespace fs = std::filesystem;
+
+// Where a chunk's payload lives, for reads that bypass the mapping (AsyncFileIO)
+struct RegionChunkLocation {
+    fs::path path;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    std::string inlineBytes;  // set instead of offset / length for inline payloads
+};
+
+struct RegionFileStats {
+    size_t chunks = 0;       // chunks stored
+    size_t fileSectors = 0;  // file size in sectors, header included
+    size_t usedSectors = 0;  // sectors holding the header or live chunk data
+    size_t sharedChunks = 0; // chunks pointing at a payload another chunk already stored
+    size_t usedEnd = 0;      // one past the last used sector, the file can be cut there
+};
+
+// One file holding REGION_SIZE^3 chunks. The file starts with a table of
+// (first sector, byte length) per chunk, followed by chunk payloads aligned
+// to 4 KB sectors. A rewrite goes to free sectors first and only then
+// switches the table entry, so the previous payload survives a crash mid-write;
+// the old sectors are reused by later writes. That ordering only survives a
+// power loss for durable writes, which sync the payload before the table entry
+// that publishes it. Reads go through a memory mapping.
+// Payloads of up to MAX_INLINE bytes (an all-air chunk is one byte) live in
+// the table entry itself and take no sector. A single-sector payload that is
+// byte-identical to one already stored (uniform stone, repeated flat terrain)
+// is not written again: both entries point at the same sector, which is freed
+// with its last reference.
+class RegionFile {
+public:
+    static constexpr int REGION_SIZE = 16;
+    static constexpr int CHUNK_COUNT = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+    static constexpr size_t SECTOR_SIZE = 4096;
+    static constexpr size_t MAX_INLINE = 3;
+
+    // One bit per chunk of a region, bit toLocalIndex(pos) set = stored
+    using PresenceMask = std::array<uint64_t, CHUNK_COUNT / 64>;
+
+    explicit RegionFile(const fs::path& path);
+    ~RegionFile();
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    bool isOpen() const { return _file.is_open(); }
+
+    static glm::ivec3 toRegionPos(const ChunkPos& pos) {
+        return glm::ivec3(pos.position.x >> 4, pos.position.y >> 4, pos.position.z >> 4);
+    }
+
+    static int toLocalIndex(const ChunkPos& pos) {
+        return (pos.position.x & (REGION_SIZE - 1))
+             + REGION_SIZE * ((pos.position.y & (REGION_SIZE - 1))
+             + REGION_SIZE * (pos.position.z & (REGION_SIZE - 1)));
+    }
+
+    bool contains(const ChunkPos& pos) const {
+        std::shared_lock lock(_mutex);
+        return _header[toLocalIndex(pos)].sector != 0;
+    }
+
+    // Calls consume(const char* data, size_t size) on the mapped payload, no copy.
+    // The pointer is only valid during the call, its pages are released afterwards.
+    template<typename Fn>
+    bool read(const ChunkPos& pos, Fn&& consume) const {
+        std::shared_lock lock(_mutex);
+        const Entry& entry = _header[toLocalIndex(pos)];
+        if (entry.sector == 0) return false;
+
+        if (entry.sector == INLINE_SECTOR) {
+            char inlineBytes[MAX_INLINE];
+            const size_t size = entry.length >> 24;
+            for (size_t i = 0; i < size; ++i) {
+                inlineBytes[i] = static_cast<char>(entry.length >> (8 * i));
+            }
+            consume(static_cast<const char*>(inlineBytes), size);
+            return true;
+        }
+
+        const size_t begin = static_cast<size_t>(entry.sector) * SECTOR_SIZE;
+        if (begin + entry.length > _mapped.size()) return false;
+
+        consume(_mapped.data() + begin, static_cast<size_t>(entry.length));
+        // The decoded chunk is the copy that stays; the OS page cache keeps the bytes
+        _mapped.release(begin, entry.length);
+        return true;
+    }
+
+    // False when the chunk is not stored. The location stays valid until the chunk is rewritten.
+    bool locate(const ChunkPos& pos, RegionChunkLocation& location) const {
+        std::shared_lock lock(_mutex);
+        const Entry& entry = _header[toLocalIndex(pos)];
+        if (entry.sector == 0) return false;
+
+        location.path = _path;
+        location.inlineBytes.clear();
+        if (entry.sector == INLINE_SECTOR) {
+            for (size_t i = 0; i < (entry.length >> 24); ++i) {
+                location.inlineBytes.push_back(static_cast<char>(entry.length >> (8 * i)));
+            }
+            location.offset = 0;
+            location.length = 0;
+            return true;
+        }
+        location.offset = static_cast<uint64_t>(entry.sector) * SECTOR_SIZE;
+        location.length = entry.length;
+        return true;
+    }
+
+    // Durable: the payload reaches the disk before the table entry is written, and the
+    // entry before the call returns (fdatasync / FlushFileBuffers, two per call). A failed
+    // final sync returns false with the entry already replaced.
+    bool write(const ChunkPos& pos, const char* data, size_t size, bool durable = false);
+    bool erase(const ChunkPos& pos, bool durable = false);
+
+    RegionFileStats getStats() const;
+
+    // Reads only the header of a region file on disk, for ChunkIndex rebuilds.
+    // Entries the constructor would drop are left out.
+    static bool readPresence(const fs::path& path, PresenceMask& mask);
+
+private:
+    struct Entry {
+        uint32_t sector = 0;  // 0 = chunk not stored, sector 0 is always header
+        uint32_t length = 0;  // for INLINE_SECTOR: size in the top byte, payload bytes below
+    };
+
+    static constexpr uint32_t INLINE_SECTOR = 0xFFFFFFFFu;
+
+    static constexpr uint32_t HEADER_SECTORS = static_cast<uint32_t>(CHUNK_COUNT * sizeof(Entry) / SECTOR_SIZE);
+    // The file grows by at least this much so appends rarely need a remap
+    static constexpr uint32_t GROWTH_SECTORS = 256;
+
+    static uint32_t sectorsFor(size_t bytes) {
+        return static_cast<uint32_t>((bytes + SECTOR_SIZE - 1) / SECTOR_SIZE);
+    }
+
+    // Same checks as the constructor applies before trusting an entry
+    static bool isValidEntry(const Entry& entry, uint32_t fileSectors);
+
+    // First fit over free sectors, growing the file when nothing fits. Returns 0 on failure.
+    uint32_t allocate(uint32_t count);
+    void markSectors(uint32_t first, uint32_t count, bool used);
+    void releaseEntry(const Entry& entry);
+    // Stored single-sector payload with exactly these bytes, 0 when there is none
+    uint32_t findSharedPayload(const char* data, size_t size);
+    void buildPayloadIndex();
+    std::string_view mappedPayload(const Entry& entry) const;
+    bool growTo(uint32_t sectors);
+    bool writeHeaderEntry(int index);
+    // Flushes written data out of the OS cache to the disk
+    bool syncData();
+
+    fs::path _path;
+    mutable std::shared_mutex _mutex;
+    std::fstream _file;
+    // Second handle on the file, only used to sync it
+#ifdef _WIN32
+    HANDLE _syncHandle = INVALID_HANDLE_VALUE;
+#else
+    int _syncFd = -1;
+#endif
+    MappedFile _mapped;
+    std::array<Entry, CHUNK_COUNT> _header{};
+    std::vector<bool> _usedSectors;
+    size_t _chunkCount = 0;
+    // Entries per first sector, only for sectors more than one entry points at
+    std::unordered_map<uint32_t, uint32_t> _sectorRefs;
+    // Payload hash -> sector of a stored single-sector payload, built on the first write
+    std::unordered_map<size_t, uint32_t> _payloadIndex;
+    bool _payloadIndexBuilt = false;
+};
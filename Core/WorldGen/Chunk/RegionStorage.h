@@ -0,0 +1,136 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkIndex.h"
+#include "ChunkPos.h"
+#include "RegionFile.h"
+
+// Keeps region files of the current worlds open. Chunks are addressed by
+// world name and ChunkPos; the region file is opened, or created on first
+// write, behind the scenes. At most MAX_OPEN_REGIONS stay open, least recently
+// used ones are closed first; a region some thread is still reading or writing
+// is never closed, so the limit can be exceeded while every open one is busy. Which chunks exist is answered by the world's
+// ChunkIndex, in memory, without opening the region.
+class RegionStorage {
+public:
+    static constexpr size_t MAX_OPEN_REGIONS = 64;
+
+    static RegionStorage& getInstance() {
+        static RegionStorage instance;
+        return instance;
+    }
+
+    bool contains(const std::string& worldName, const ChunkPos& pos) {
+        return getIndex(worldName).contains(pos);
+    }
+
+    // See RegionFile::read, consume(const char* data, size_t size)
+    template<typename Fn>
+    bool read(const std::string& worldName, const ChunkPos& pos, Fn&& consume) {
+        auto region = getRegion(worldName, pos, false);
+        return region && region->read(pos, std::forward<Fn>(consume));
+    }
+
+    bool locate(const std::string& worldName, const ChunkPos& pos, RegionChunkLocation& location) {
+        if (!contains(worldName, pos)) return false;
+        auto region = getRegion(worldName, pos, false);
+        return region && region->locate(pos, location);
+    }
+
+    // Durable: see RegionFile::write
+    bool write(const std::string& worldName, const ChunkPos& pos, const std::string& bytes, bool durable = false) {
+        auto region = getRegion(worldName, pos, true);
+        if (!region) return false;
+        const bool written = region->write(pos, bytes.data(), bytes.size(), durable);
+        if (written || region->contains(pos)) getIndex(worldName).set(pos, true);
+        return written;
+    }
+
+    bool erase(const std::string& worldName, const ChunkPos& pos, bool durable = false) {
+        auto region = getRegion(worldName, pos, false);
+        if (!region) return false;
+        const bool erased = region->erase(pos, durable);
+        if (!region->contains(pos)) getIndex(worldName).set(pos, false);
+        return erased;
+    }
+
+    // Every chunk saved in the world, grouped by region
+    std::vector<ChunkPos> listChunks(const std::string& worldName) {
+        return getIndex(worldName).getPositions();
+    }
+
+    // Loads, or rebuilds, the chunk index of the world. Called when the world opens
+    // so the first existence checks do not pay for it.
+    void openWorld(const std::string& worldName) {
+        getIndex(worldName);
+    }
+
+    // Puts replacement in place of the region file (see worldAnalyzer --compact) and
+    // reads the region's chunk index bits back from its header. False when the region
+    // is still in use or the rename fails, the old file is then left alone.
+    bool replaceRegion(const std::string& worldName, const glm::ivec3& regionPos, const fs::path& replacement);
+    // Removes the region file and its chunks from the index
+    bool removeRegion(const std::string& worldName, const glm::ivec3& regionPos);
+
+    // Moves a world saved as one Chunk_x_y_z file per chunk into region files
+    // and removes the old files. Returns the number of chunks moved.
+    size_t convertLegacyChunks(const std::string& worldName);
+
+    // Closes every region and writes the chunk indices back
+    void closeAll();
+
+private:
+    struct RegionKey {
+        std::string worldName;
+        glm::ivec3 regionPos;
+
+        bool operator==(const RegionKey& other) const {
+            return regionPos == other.regionPos && worldName == other.worldName;
+        }
+    };
+
+    struct RegionKeyHash {
+        size_t operator()(const RegionKey& key) const noexcept {
+            return std::hash<std::string>{}(key.worldName) ^ std::hash<ChunkPos>{}(ChunkPos(key.regionPos));
+        }
+    };
+
+    struct OpenRegion {
+        std::shared_ptr<RegionFile> file;
+        std::list<RegionKey>::iterator lruIt;
+    };
+
+    RegionStorage() = default;
+    ~RegionStorage() = default;
+
+    RegionStorage(const RegionStorage&) = delete;
+    RegionStorage& operator=(const RegionStorage&) = delete;
+
+    // nullptr when the region does not exist and create is false
+    std::shared_ptr<RegionFile> getRegion(const std::string& worldName, const ChunkPos& pos, bool create);
+
+    ChunkIndex& getIndex(const std::string& worldName);
+
+    // Closes the region ahead of a change to its file and drops the descriptor
+    // AsyncFileIO keeps of it. False while some thread still holds the region.
+    bool releaseRegion(const RegionKey& key, const fs::path& path);
+
+    std::mutex _mutex;
+    std::unordered_map<RegionKey, OpenRegion, RegionKeyHash> _open;
+    std::list<RegionKey> _lru;
+    // Regions known to have no file yet, saves a stat per chunk in unexplored areas
+    std::unordered_set<RegionKey, RegionKeyHash> _missing;
+
+    // Separate from _mutex, existence checks must not wait behind a region being opened
+    std::mutex _indexMutex;
+    std::unordered_map<std::string, std::unique_ptr<ChunkIndex>> _indices;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "IChunkGenerator.h"
+
+// Hills of dirt over gneiss on a stone floor, in the y == 0 chunk layer only.
+class TerrainGenerator : public IChunkGenerator {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    explicit TerrainGenerator(uint64_t seed) : _seed(seed) {}
+
+    std::shared_ptr<ChunkBlockStorage> generateChunk(const ChunkPos& chunkPos) const override {
+        auto storage = std::make_shared<ChunkBlockStorage>();
+        if (chunkPos.position.y != 0) {
+            return storage;
+        }
+
+        constexpr int size = ChunkBlockStorage::SIZE;
+
+        // Palette indices written straight into one array, handed to the storage in one go
+        static const std::vector<Blocks> palette = {
+            Blocks::Air, Blocks::Stone, Blocks::Gneiss, Blocks::Dirt, Blocks::Sand, Blocks::Gravel, Blocks::SporeMoss
+        };
+        enum : uint16_t { Air, Stone, Gneiss, Dirt, Sand, Gravel, SporeMoss };
+        std::vector<uint16_t> indices(ChunkBlockStorage::VOLUME, Air);
+
+        for (int x = 0; x < size; ++x) {
+            for (int z = 0; z < size; ++z) {
+
+                int surfaceHeight = getSurfaceHeight(x, z);
+                
+                for (int y = 0; y < size; ++y) {
+                    uint16_t block = Air; // по умолчанию воздух
+
+                    if (y == 0) {
+                        block = Stone; // самый низ - камень
+                    } else if (y < surfaceHeight - 2) {
+                        block = Gneiss; // слой гнейса под землёй
+                    } else if (y < surfaceHeight - 1) {
+                        block = Dirt; // земля под поверхностью
+                    } else if (y == surfaceHeight - 1) {
+                        // Верхний слой - с шансом песок или гравий, либо споровый мох
+                        float r = columnRandom(chunkPos, x, z);
+
+                        if (r < 0.1f) {
+                            block = Sand;
+                        } else if (r < 0.15f) {
+                            block = Gravel;
+                        } else if (r < 0.2f) {
+                            block = SporeMoss;
+                        } else {
+                            block = Dirt;
+                        }
+                    }
+                    // Немного воздуха внутри - маленькие пещеры
+                    else if (y < surfaceHeight && (x + z + y) % 7 == 0) {
+                        block = Air;
+                    } else if (y < surfaceHeight) {
+                        block = Dirt;
+                    }
+
+                    indices[ChunkBlockStorage::toIndex(x, y, z)] = block;
+                }
+            }
+        }
+
+        storage->assign(palette, indices);
+        return storage;
+    }
+
+    generationType getGeneratorType() const override { return generationType::Noise; }
+    uint32_t getVersion() const override { return VERSION; }
+    uint64_t getSeed() const override { return _seed; }
+    bool isReady() const override { return true; }
+
+    static int getSurfaceHeight(int x, int z) {
+        float height = 3.0f + 2.0f * sinf(x * 0.3f) * cosf(z * 0.3f);
+        return static_cast<int>(height);
+    }
+
+private:
+    uint64_t _seed;
+
+    // [0, 1) from the seed and the world column alone, so the result does not
+    // depend on which thread generates the chunk or in what order (splitmix64)
+    float columnRandom(const ChunkPos& chunkPos, int x, int z) const {
+        const uint32_t worldX = static_cast<uint32_t>(chunkPos.position.x * ChunkBlockStorage::SIZE + x);
+        const uint32_t worldZ = static_cast<uint32_t>(chunkPos.position.z * ChunkBlockStorage::SIZE + z);
+        uint64_t h = _seed ^ ((static_cast<uint64_t>(worldX) << 32) | worldZ);
+        h += 0x9E3779B97F4A7C15ull;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return static_cast<float>(h >> 40) * (1.0f / 16777216.0f);
+    }
+};
@@ -0,0 +1,25 @@
+#include "BlockEditTransaction.h"
+#include "ChunkController.h"
+
+BlockEditTransaction::BlockEditTransaction(ChunkController& controller)
+    : _controller(&controller)
+{
+}
+
+void BlockEditTransaction::set(const BlockPos& worldPos, Blocks id) {
+    auto [chunkPos, localPos] = _controller->toChunkLocal(worldPos);
+    _edits[chunkPos].emplace_back(localPos, id);
+    ++_editCount;
+}
+
+void BlockEditTransaction::breakBlock(const BlockPos& worldPos) {
+    set(worldPos, Blocks::Air);
+}
+
+size_t BlockEditTransaction::commit() {
+    if (_edits.empty()) return 0;
+    const size_t applied = _controller->applyEdits(_edits);
+    _edits.clear();
+    _editCount = 0;
+    return applied;
+}
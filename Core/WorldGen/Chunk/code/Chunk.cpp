@@ -1,23 +1,31 @@
 #include "Chunk.h"
-#include "ServiceLocator.h"
 
 #include "BlockCache.h"
+#include "BlockFace.h"
 
 #include <GL/glext.h>
 
+#include <cassert>
+
 Chunk::Chunk(const ChunkPos& pos)
-    : blocks(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE), _mesh(*this), chunkPos(pos)
+    : blocks(std::make_shared<ChunkBlockStorage>()), _mesh(*this), chunkPos(pos)
 {
-    auto sharedAirBlock = BlockFactory::getInstance().getSharedAirBlock();
+}
 
-    for (int y = 0; y < CHUNK_SIZE; ++y) {
-        for (int z = 0; z < CHUNK_SIZE; ++z) {
-            for (int x = 0; x < CHUNK_SIZE; ++x) {
-                BlockPos pos{ glm::ivec3(x, y, z) };
-                blocks[toIndex(pos)] = sharedAirBlock;
-            }
-        }
+void Chunk::reset(const ChunkPos& pos) {
+    chunkPos = pos;
+    clearParked();
+    lastAccess = 0;
+    if (blocks.use_count() == 1) {
+        blocks->fill(Blocks::Air);
+    } else {
+        blocks = std::make_shared<ChunkBlockStorage>();
     }
+    version.fetch_add(1, std::memory_order_release);
+    blockEntities.clear();
+    blocksOpaqueData.clear();
+    _mesh.reset();
+    canBeDeleted.store(true, std::memory_order_release);
 }
 
 void Chunk::markSavingStarted() {
@@ -32,75 +40,219 @@ bool Chunk::isDeletable() const {
     return canBeDeleted.load(std::memory_order_acquire);
 }
 
-std::shared_ptr<Block>& Chunk::getBlockPtr(BlockPos pos) {
-    return blocks[toIndex(pos)];
+const Block& Chunk::getBlock(BlockPos pos) const {
+    assert(!parked);
+    int idx = toIndex(pos);
+    // Most chunks have no side table entries at all, skip the hash
+    if (!blockEntities.empty()) {
+        auto it = blockEntities.find(idx);
+        if (it != blockEntities.end()) return *it->second;
+    }
+    return *BlockFactory::getInstance().getSharedBlock(blocks->get(idx));
 }
 
-const std::shared_ptr<Block>& Chunk::getBlockPtr(BlockPos pos) const {
-    return blocks[toIndex(pos)];
+Block& Chunk::blockToNotify(int idx) {
+    auto it = blockEntities.find(idx);
+    if (it != blockEntities.end()) return *it->second;
+    return *BlockFactory::getInstance().getSharedBlock(blocks->get(idx));
 }
 
-Block& Chunk::getBlock(BlockPos pos) {
-    return *blocks[toIndex(pos)];
+Block& Chunk::placeBlock(int idx, Blocks blockType) {
+    auto& factory = BlockFactory::getInstance();
+
+    editableBlocks().set(idx, blockType);
+    blockEntities.erase(idx);
+    version.fetch_add(1, std::memory_order_release);
+
+    const int x = idx % CHUNK_SIZE;
+    const int y = (idx / CHUNK_SIZE) % CHUNK_SIZE;
+    const int z = idx / (CHUNK_SIZE * CHUNK_SIZE);
+    blocksOpaqueData.setOpaque(x, y, z, BlockCache::getInstance().getBlockInfo(blockType).isOpaque);
+
+    if (factory.isShared(blockType)) {
+        return *factory.getSharedBlock(blockType);
+    }
+    auto& entity = blockEntities[idx];
+    entity = factory.create(blockType);
+    return *entity;
 }
 
-const Block& Chunk::getBlock(BlockPos pos) const {
-    return *blocks[toIndex(pos)];
+ChunkEditResult Chunk::applyEdits(const std::vector<std::pair<BlockPos, Blocks>>& edits) {
+    assert(!parked);
+    auto& factory = BlockFactory::getInstance();
+    ChunkEditResult result;
+
+    for (const auto& [pos, blockType] : edits) {
+        int idx = toIndex(pos);
+        if (idx < 0 || idx >= ChunkBlockStorage::VOLUME) continue;
+
+        const Blocks current = blocks->get(idx);
+        if (blockType == Blocks::Air) {
+            if (current == Blocks::Air) continue;
+            blockToNotify(idx).onBreak();
+            placeBlock(idx, Blocks::Air);
+        } else {
+            // A per-instance block placed again starts over with a fresh state, a stateless one is the same block
+            if (current == blockType && factory.isShared(blockType)) continue;
+            placeBlock(idx, blockType).onPlace();
+        }
+        ++result.applied;
+        result.borderFaces |= borderFaces(pos.position);
+    }
+
+    if (result.applied > 0) markChunkDirty(true);
+    return result;
 }
 
-void Chunk::setBlock(BlockPos pos, const Blocks blockType) {
-    int idx = toIndex(pos);
+const ChunkBlockStorage& Chunk::getBlocks() const {
+    assert(!parked);
+    return *blocks;
+}
 
-    if (blockType == Blocks::Air) {
-        blocks[idx] = BlockFactory::getInstance().getSharedAirBlock();
-    } else {
-        blocks[idx] = BlockFactory::getInstance().create(blockType);
-        blocks[idx]->onPlace();
+ChunkBlockStorage& Chunk::editableBlocks() {
+    // Only the editing thread creates new references, so a count of 1 cannot grow behind our back
+    if (blocks.use_count() > 1) {
+        blocks = std::make_shared<ChunkBlockStorage>(*blocks);
     }
+    return *blocks;
+}
 
-    markChunkDirty();
-    ServiceLocator::GetWorld()->getChunkController().getChunkDataAccess()->saveChunkToDisk(chunkPos, *this, ServiceLocator::GetWorld()->getWorldName());
-    updateNearChunks(pos.position);
+ChunkSnapshot Chunk::snapshot() const {
+    assert(!parked);
+    ChunkSnapshot snap;
+    snap.pos = chunkPos;
+    snap.version = version.load(std::memory_order_acquire);
+    snap.blocks = blocks;
+    snap.blockProperties.reserve(blockEntities.size());
+    for (const auto& [idx, entity] : blockEntities) {
+        snap.blockProperties.emplace_back(idx, entity->getBlockProperties());
+    }
+    return snap;
 }
 
-void Chunk::breakBlock(BlockPos pos) {
-    int idx = toIndex(pos);
-    blocks[idx]->onBreak();
-    blocks[idx] = BlockFactory::getInstance().getSharedAirBlock();
+uint64_t Chunk::getVersion() const {
+    return version.load(std::memory_order_acquire);
+}
+
+void Chunk::restore(const ChunkSnapshot& snapshot) {
+    // Safe to share: editableBlocks() copies while the snapshot still holds it
+    assignBlocks(std::const_pointer_cast<ChunkBlockStorage>(snapshot.blocks));
+
+    for (const auto& [idx, props] : snapshot.blockProperties) {
+        auto it = blockEntities.find(idx);
+        if (it != blockEntities.end()) {
+            it->second->setBlockProperties(props);
+        }
+    }
+    markSaved(getVersion());
+}
+
+void Chunk::assignBlocks(std::shared_ptr<ChunkBlockStorage> storage) {
+    auto& factory = BlockFactory::getInstance();
+
+    clearParked();
+    blocks = std::move(storage);
+    blockEntities.clear();
+
+    const auto& palette = blocks->getPalette();
+    for (size_t entry = 0; entry < palette.size(); ++entry) {
+        if (factory.isShared(palette[entry]) || blocks->getPaletteRefs()[entry] == 0) continue;
+        for (int idx = 0; idx < ChunkBlockStorage::VOLUME; ++idx) {
+            if (blocks->getPaletteIndex(idx) == entry) {
+                blockEntities[idx] = factory.create(palette[entry]);
+            }
+        }
+    }
+
+    updateChunkBlocksOpaqueData();
     markChunkDirty();
-    ServiceLocator::GetWorld()->getChunkController().getChunkDataAccess()->saveChunkToDisk(chunkPos, *this, ServiceLocator::GetWorld()->getWorldName());
-    updateNearChunks(pos.position);
+    version.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool Chunk::isDirty() const {
+    return version.load(std::memory_order_acquire) != savedVersion.load(std::memory_order_acquire);
+}
+
+void Chunk::markSaved(uint64_t saved) {
+    savedVersion.store(saved, std::memory_order_release);
+}
+
+const std::unordered_map<int, std::shared_ptr<Block>>& Chunk::getBlockEntities() const {
+    return blockEntities;
 }
 
-const std::vector<std::shared_ptr<Block>>& Chunk::getBlocks() const {
-    return blocks;
+void Chunk::setBlockProperties(BlockPos pos, const std::string& properties) {
+    auto it = blockEntities.find(toIndex(pos));
+    if (it != blockEntities.end()) {
+        it->second->setBlockProperties(properties);
+    }
 }
 
 void Chunk::updateChunkBlocksOpaqueData() {
-    for (int y = 0; y < CHUNK_SIZE; ++y) {
-        for (int z = 0; z < CHUNK_SIZE; ++z) {
+    assert(!parked);
+    const ChunkBlockStorage& blocks = *this->blocks;
+    if (blocks.isUniform()) {
+        blocksOpaqueData.fill(BlockCache::getInstance().getBlockInfo(blocks.getUniformBlock()).isOpaque);
+        return;
+    }
+
+    const auto& palette = blocks.getPalette();
+    std::vector<uint32_t> paletteOpaque(palette.size());
+    for (size_t i = 0; i < palette.size(); ++i) {
+        paletteOpaque[i] = BlockCache::getInstance().getBlockInfo(palette[i]).isOpaque ? 1u : 0u;
+    }
+
+    for (int z = 0; z < CHUNK_SIZE; ++z) {
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            uint32_t row = 0;
+            int rowStart = ChunkBlockStorage::toIndex(0, y, z);
             for (int x = 0; x < CHUNK_SIZE; ++x) {
-                int index = x + CHUNK_SIZE * (y + CHUNK_SIZE * z);
-                Block& block = *blocks[index];
-                blocksOpaqueData.setOpaque(x, y, z, BlockCache::getInstance().getBlockInfo(block.getBlockId()).isOpaque);
+                row |= paletteOpaque[blocks.getPaletteIndex(rowStart + x)] << x;
             }
+            blocksOpaqueData.setRow(y, z, row);
         }
     }
 }
 
+const ChunkBlocksOpaqueData& Chunk::getBlocksOpaqueData() const {
+    assert(!parked);
+    return blocksOpaqueData;
+}
+
 ChunkBlocksOpaqueData* Chunk::getBlocksOpaqueData() {
+    assert(!parked);
     return &blocksOpaqueData;
 }
 
+bool Chunk::isEmpty() const {
+    // Empty chunks are never parked
+    if (parked) return false;
+    return blocks->isUniform() && blocks->getUniformBlock() == Blocks::Air;
+}
+
+bool Chunk::hasGeometry() const {
+    return _mesh.needUpdate || _mesh.isBuilding() || _mesh.indexCount > 0;
+}
+
 void Chunk::render(Shader shader, const glm::vec3& sunDirection, const glm::vec3& sunColor) {
+    if (!hasGeometry()) return;
     _mesh.render(shader, sunDirection, sunColor);
 }
 
-void Chunk::markChunkDirty() {
+void Chunk::markChunkDirty(bool urgent) {
     _mesh.needUpdate = true;
+    _mesh.urgent = _mesh.urgent || urgent;
     _mesh.isUploaded = false;
 }
 
+std::unique_ptr<ChunkMeshJob> Chunk::takeMeshJob() {
+    return _mesh.takeJob();
+}
+
+bool Chunk::finishMeshJob(ChunkMeshJob& job) {
+    return _mesh.finishJob(job);
+}
+
 int Chunk::toIndex(BlockPos pos) const {
     return pos.position.x + CHUNK_SIZE * (pos.position.y + CHUNK_SIZE * pos.position.z);
 }
@@ -109,18 +261,6 @@ const ChunkPos Chunk::getChunkPos() const {
     return chunkPos;
 }
 
-void Chunk::setBlocks(const std::vector<std::pair<BlockPos, Blocks>>& changes) {
-    for (const auto& [pos, blockType] : changes) {
-        int idx = toIndex(pos);
-        if (idx < 0 || idx >= (int)blocks.size()) continue;
-
-        blocks[idx] = BlockFactory::getInstance().create(blockType);
-        blocks[idx]->onPlace();
-        updateNearChunks(pos.position);
-    }
-    markChunkDirty();
-}
-
 void Chunk::renderDepth(Shader& depthShader) {
     if (_mesh.indexCount == 0 || _mesh.VAO == 0) return;
 
@@ -135,37 +275,87 @@ void Chunk::renderDepth(Shader& depthShader) {
     glBindVertexArray(0);
 }
 
-void Chunk::updateNearChunks(glm::ivec3 localPos) {
-    const int s = Chunk::CHUNK_SIZE;
+bool Chunk::park() {
+    if (parked || isDirty() || isEmpty() || _mesh.needUpdate || _mesh.isBuilding()) return false;
 
-    const bool atMinX = localPos.x == 0;
-    const bool atMaxX = localPos.x == s - 1;
-    const bool atMinY = localPos.y == 0;
-    const bool atMaxY = localPos.y == s - 1;
-    const bool atMinZ = localPos.z == 0;
-    const bool atMaxZ = localPos.z == s - 1;
+    for (int face = 0; face < 6; ++face) {
+        getBorderLayer(face, parkedBorders[face]);
+    }
+    blocks.reset();
+    blocksOpaqueData.release();
+    _mesh.releaseCpuCopy();
+    parked = true;
+    parkedCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool Chunk::isParked() const {
+    return parked;
+}
+
+void Chunk::unpark(std::shared_ptr<const ChunkBlockStorage> storage) {
+    if (!parked) return;
+    // Shared like restore(): editableBlocks() copies before the first write
+    blocks = std::const_pointer_cast<ChunkBlockStorage>(std::move(storage));
+    clearParked();
+    updateChunkBlocksOpaqueData();
+}
 
-    if (!(atMinX || atMaxX || atMinY || atMaxY || atMinZ || atMaxZ)) {
+void Chunk::getBorderLayer(int face, std::array<uint32_t, CHUNK_SIZE>& layer) const {
+    if (parked) {
+        layer = parkedBorders[face];
         return;
     }
 
-    if (atMinX) updateNeighborMesh({-1, 0, 0});
-    if (atMaxX) updateNeighborMesh({ 1, 0, 0});
-    if (atMinY) updateNeighborMesh({ 0,-1, 0});
-    if (atMaxY) updateNeighborMesh({ 0, 1, 0});
-    if (atMinZ) updateNeighborMesh({ 0, 0,-1});
-    if (atMaxZ) updateNeighborMesh({ 0, 0, 1});
+    // faces[]: +X, -X, +Y, -Y, +Z, -Z
+    const int s = CHUNK_SIZE;
+    const int side = (face & 1) ? 0 : s - 1;
+    layer.fill(0);
+    for (int a = 0; a < s; ++a) {
+        if (face < 2) {
+            for (int y = 0; y < s; ++y) layer[a] |= ((blocksOpaqueData.getRow(y, a) >> side) & 1u) << y;
+        } else if (face < 4) {
+            layer[a] = blocksOpaqueData.getRow(side, a);
+        } else {
+            layer[a] = blocksOpaqueData.getRow(a, side);
+        }
+    }
+}
+
+void Chunk::touch() {
+    lastAccess = accessClock.load(std::memory_order_relaxed);
 }
 
-void Chunk::updateNeighborMesh(glm::ivec3 offset) {
-    auto world = ServiceLocator::GetWorld();
-    ChunkPos neighborPos = chunkPos;
-    neighborPos.position += offset;
+void Chunk::clearParked() {
+    if (!parked) return;
+    parked = false;
+    parkedCount.fetch_sub(1, std::memory_order_relaxed);
+}
 
-    auto neighbor = world->getChunkController().getChunk(neighborPos);
-    if (neighbor.has_value()) {
-        neighbor.value().get()._mesh.needUpdate = true;
-        neighbor.value().get()._mesh.isUploaded = false;
-        neighbor.value().get().updateChunkBlocksOpaqueData();
-    }
-}
\ No newline at end of file
+uint32_t Chunk::getLastAccess() const {
+    return lastAccess;
+}
+
+void Chunk::advanceAccessClock() {
+    accessClock.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t Chunk::getAccessClock() {
+    return accessClock.load(std::memory_order_relaxed);
+}
+
+size_t Chunk::getParkedCount() {
+    return parkedCount.load(std::memory_order_relaxed);
+}
+
+uint8_t Chunk::borderFaces(glm::ivec3 localPos) {
+    const int s = Chunk::CHUNK_SIZE;
+
+    // Bit order follows faces[]: +X, -X, +Y, -Y, +Z, -Z
+    return (localPos.x == s - 1 ? 1u << 0 : 0u)
+         | (localPos.x == 0     ? 1u << 1 : 0u)
+         | (localPos.y == s - 1 ? 1u << 2 : 0u)
+         | (localPos.y == 0     ? 1u << 3 : 0u)
+         | (localPos.z == s - 1 ? 1u << 4 : 0u)
+         | (localPos.z == 0     ? 1u << 5 : 0u);
+}
@@ -1,9 +1,33 @@
 #include "ChunkController.h"
+#include "BlockFace.h"
+#include "RegionFile.h"
+#include "RegionStorage.h"
+#include "ChunkMeshCache.h"
+#include "ServiceLocator.h"
 
-std::optional<std::reference_wrapper<Chunk>> ChunkController::getChunk(const ChunkPos& pos) const {
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <future>
+
+std::optional<std::reference_wrapper<Chunk>> ChunkController::getChunk(const ChunkPos& pos) {
+    auto chunkOpt = _chunkMemoryContainer->getChunk(pos);
+    if (chunkOpt) makeResident(chunkOpt->get());
+    return chunkOpt;
+}
+
+std::optional<std::reference_wrapper<Chunk>> ChunkController::findChunk(const ChunkPos& pos) const {
     return _chunkMemoryContainer->getChunk(pos);
 }
 
+Chunk& ChunkController::makeResident(Chunk& chunk) {
+    assert(std::this_thread::get_id() == _mainThread);
+    chunk.touch();
+    if (chunk.isParked()) unpark(chunk);
+    return chunk;
+}
+
 bool ChunkController::hasChunk(const ChunkPos& pos) const {
     return _chunkMemoryContainer->getChunk(pos).has_value();
 }
@@ -20,82 +44,291 @@ glm::ivec3 ChunkController::worldToChunk(const glm::ivec3& worldPos) const {
     );
 }
 
+std::pair<ChunkPos, BlockPos> ChunkController::toChunkLocal(const BlockPos& worldPos) const {
+    auto toLocal = [](int globalCoord) {
+        int local = globalCoord % Chunk::CHUNK_SIZE;
+        if (local < 0) local += Chunk::CHUNK_SIZE;
+        return local;
+    };
+
+    glm::ivec3 localPos{
+        toLocal(worldPos.position.x),
+        toLocal(worldPos.position.y),
+        toLocal(worldPos.position.z)
+    };
+
+    return { ChunkPos(worldToChunk(worldPos.position)), BlockPos(localPos) };
+}
+
 void ChunkController::setBlock(const BlockPos& pos, Blocks id) {
-    auto chunkOpt = getChunk(ChunkPos(worldToChunk(pos.position)));
+    auto edit = beginEdit();
+    edit.set(pos, id);
+    edit.commit();
+}
+
+std::optional<std::reference_wrapper<const Block>> ChunkController::getBlock(const BlockPos& pos) {
+    auto [chunkPos, localPos] = toChunkLocal(pos);
+    auto chunkOpt = getChunk(chunkPos);
     if (chunkOpt) {
-        auto toLocal = [](int globalCoord) {
-            int local = globalCoord % Chunk::CHUNK_SIZE;
-            if (local < 0) local += Chunk::CHUNK_SIZE;
-            return local;
-        };
+        return chunkOpt->get().getBlock(localPos);
+    }
+    return std::nullopt;
+}
+
+void ChunkController::breakBlock(const BlockPos& pos) {
+    auto edit = beginEdit();
+    edit.breakBlock(pos);
+    edit.commit();
+}
+
+BlockEditTransaction ChunkController::beginEdit() {
+    return BlockEditTransaction(*this);
+}
+
+size_t ChunkController::applyEdits(const std::unordered_map<ChunkPos, std::vector<std::pair<BlockPos, Blocks>>>& edits) {
+    std::unordered_set<ChunkPos> borderNeighbors;
+    std::unordered_set<ChunkPos> changed;
+    size_t applied = 0;
+
+    for (const auto& [chunkPos, chunkEdits] : edits) {
+        auto chunkOpt = getChunk(chunkPos);
+        if (!chunkOpt) continue;
+        Chunk& chunk = chunkOpt->get();
 
-        glm::ivec3 localPos{
-            toLocal(pos.position.x),
-            toLocal(pos.position.y),
-            toLocal(pos.position.z)
-        };
+        const ChunkEditResult result = chunk.applyEdits(chunkEdits);
+        if (result.applied == 0) continue;
+        applied += result.applied;
+        changed.insert(chunkPos);
 
-        chunkOpt->get().setBlock(BlockPos(localPos), id);
+        ChunkSnapshot snapshot = chunk.snapshot();
+        chunk.markSaved(snapshot.version);
+        ChunkSaver::getInstance().schedule(std::move(snapshot), worldName);
+
+        for (int face = 0; face < 6; ++face) {
+            if (result.borderFaces & (1u << face)) {
+                borderNeighbors.insert(ChunkPos(chunkPos.position + faces[face].neighborOffset));
+            }
+        }
+    }
+
+    for (const auto& neighborPos : borderNeighbors) {
+        if (!changed.contains(neighborPos)) {
+            markChunkDirty(neighborPos, true);
+        }
     }
+    return applied;
 }
 
-std::optional<std::reference_wrapper<Block>> ChunkController::getBlock(const BlockPos& pos) const {
-    auto chunkOpt = getChunk(ChunkPos(worldToChunk(pos.position)));
-    if (chunkOpt) {
+size_t ChunkController::checkpoint(const std::function<void(size_t, size_t)>& onProgress) {
+    // Older snapshots still queued in ChunkSaver must not land after the ones written here.
+    // Those it failed to write are taken over: they hold edits of chunks already marked saved.
+    auto& saver = ChunkSaver::getInstance();
+    std::vector<ChunkSnapshot> snapshots;
+    if (saver.flush() > 0) {
+        snapshots = saver.takePending(worldName);
+    }
+
+    std::unordered_map<ChunkPos, size_t> taken;
+    for (size_t i = 0; i < snapshots.size(); ++i) {
+        taken.emplace(snapshots[i].pos, i);
+    }
+    // Dirty chunks are never parked
+    for (const auto& pos : _chunkMemoryContainer->getLoadedChunksPosition()) {
+        auto chunkOpt = findChunk(pos);
+        if (!chunkOpt || !chunkOpt->get().isDirty()) continue;
+        // Newer than the failed snapshot of the same chunk
+        if (auto it = taken.find(pos); it != taken.end()) {
+            snapshots[it->second] = chunkOpt->get().snapshot();
+        } else {
+            snapshots.push_back(chunkOpt->get().snapshot());
+        }
+    }
 
-        auto toLocal = [](int globalCoord) {
-            int local = globalCoord % Chunk::CHUNK_SIZE;
-            if (local < 0) local += Chunk::CHUNK_SIZE;
-            return local;
-        };
+    const size_t total = snapshots.size();
+    if (onProgress) onProgress(0, total);
+    if (total == 0) return 0;
 
-        glm::ivec3 localPos{
-            toLocal(pos.position.x),
-            toLocal(pos.position.y),
-            toLocal(pos.position.z)
-        };
+    // Chunks of one region end up in one batch, workers do not queue on each other's region lock
+    std::sort(snapshots.begin(), snapshots.end(), [](const ChunkSnapshot& a, const ChunkSnapshot& b) {
+        const glm::ivec3 ra = RegionFile::toRegionPos(a.pos);
+        const glm::ivec3 rb = RegionFile::toRegionPos(b.pos);
+        if (ra.x != rb.x) return ra.x < rb.x;
+        if (ra.y != rb.y) return ra.y < rb.y;
+        return ra.z < rb.z;
+    });
 
-        return chunkOpt->get().getBlock(BlockPos(localPos));
+    std::vector<uint8_t> saved(total, 0);
+    std::atomic<size_t> done{0};
+    auto writeRange = [&](size_t begin, size_t end) {
+        ChunkDataAccess dataAccess;
+        for (size_t i = begin; i < end; ++i) {
+            saved[i] = dataAccess.saveChunkToDisk(snapshots[i], worldName, true) ? 1 : 0;
+            done.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    auto& pool = ThreadPool::getInstance();
+    const size_t batchCount = std::min(total, pool.getWorkerCount() * 4);
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<std::future<void>> futures;
+    for (size_t b = 0; b < batchCount; ++b) {
+        ranges.emplace_back(total * b / batchCount, total * (b + 1) / batchCount);
+        try {
+            futures.push_back(pool.enqueueChunkTask([&writeRange, range = ranges.back()] {
+                writeRange(range.first, range.second);
+            }));
+        } catch (const std::runtime_error&) {
+            futures.emplace_back();
+        }
     }
-    return std::nullopt;
+
+    for (size_t b = 0; b < batchCount; ++b) {
+        // Pool stopping, or the task was pushed out of a full queue: write the batch here
+        if (!futures[b].valid()) {
+            writeRange(ranges[b].first, ranges[b].second);
+            continue;
+        }
+        while (futures[b].wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+            if (onProgress) onProgress(done.load(std::memory_order_relaxed), total);
+        }
+        try {
+            futures[b].get();
+        } catch (const std::future_error&) {
+            writeRange(ranges[b].first, ranges[b].second);
+        }
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < total; ++i) {
+        auto chunkOpt = findChunk(snapshots[i].pos);
+        if (saved[i]) {
+            if (chunkOpt) chunkOpt->get().markSaved(snapshots[i].version);
+            continue;
+        }
+        ++failed;
+        // A dirty chunk is saved again later; otherwise the snapshot is the only copy of its edits
+        if (!chunkOpt || !chunkOpt->get().isDirty()) {
+            saver.schedule(std::move(snapshots[i]), worldName);
+        }
+    }
+
+    if (onProgress) onProgress(total, total);
+    Logger::getInstance().Log(
+        "Checkpoint: " + std::to_string(total - failed) + " chunks saved" +
+        (failed > 0 ? ", " + std::to_string(failed) + " failed" : ""),
+        failed > 0 ? LogLevel::Error : LogLevel::Info
+    );
+    return failed;
 }
 
-void ChunkController::breakBlock(const BlockPos& pos) {
-    auto chunkOpt = getChunk(ChunkPos(worldToChunk(pos.position)));
-    if (chunkOpt) {
-        auto toLocal = [](int globalCoord) {
-            int local = globalCoord % Chunk::CHUNK_SIZE;
-            if (local < 0) local += Chunk::CHUNK_SIZE;
-            return local;
-        };
+bool ChunkController::autosaveStep() {
+    if (_autosaveQueue.empty()) {
+        _autosaveQueue = _chunkMemoryContainer->getLoadedChunksPosition();
+    }
+
+    for (size_t visited = 0; visited < AUTOSAVE_CHUNKS_PER_STEP && !_autosaveQueue.empty(); ++visited) {
+        ChunkPos pos = _autosaveQueue.back();
+        _autosaveQueue.pop_back();
+
+        auto chunkOpt = findChunk(pos);
+        if (!chunkOpt || !chunkOpt->get().isDirty()) continue;
+
+        Chunk& chunk = chunkOpt->get();
+        ChunkSnapshot snapshot = chunk.snapshot();
+        chunk.markSaved(snapshot.version);
+        ChunkSaver::getInstance().schedule(std::move(snapshot), worldName);
+    }
+    return _autosaveQueue.empty();
+}
+
+void ChunkController::unpark(Chunk& chunk) {
+    auto blocks = _chunkDataAccess->reloadBlocks(chunk.getChunkPos(), worldName);
+    if (!blocks) {
+        // Still clean, so the air is never written over whatever is on disk
+        Logger::getInstance().Log("Parked chunk " + chunk.getChunkPos().toString() + " could not be reloaded",
+            LogLevel::Error);
+        blocks = std::make_shared<ChunkBlockStorage>();
+    }
+    chunk.unpark(std::move(blocks));
+}
+
+void ChunkController::parkIdleChunks(const ChunkPos& center) {
+    if (_parkQueue.empty()) {
+        _parkQueue = _chunkMemoryContainer->getLoadedChunksPosition();
+    }
+
+    const uint32_t now = Chunk::getAccessClock();
+    for (size_t visited = 0; visited < PARK_CHUNKS_PER_STEP && !_parkQueue.empty(); ++visited) {
+        ChunkPos pos = _parkQueue.back();
+        _parkQueue.pop_back();
 
-        glm::ivec3 localPos{
-            toLocal(pos.position.x),
-            toLocal(pos.position.y),
-            toLocal(pos.position.z)
-        };
+        const glm::ivec3 offset = glm::abs(pos.position - center.position);
+        if (std::max({ offset.x, offset.y, offset.z }) <= PARK_MIN_DISTANCE) continue;
 
-        chunkOpt->get().breakBlock(BlockPos(localPos));
+        auto chunkOpt = findChunk(pos);
+        if (!chunkOpt) continue;
+        Chunk& chunk = chunkOpt->get();
+        if (chunk.isParked() || now - chunk.getLastAccess() < PARK_IDLE_TICKS) continue;
+        chunk.park();
     }
 }
 
 void ChunkController::renderAllChunks(Shader& shader, const glm::vec3& sunDirection, const glm::vec3& sunColor) {
     auto chunkPositions = _chunkMemoryContainer->getLoadedChunksPosition();
+    updateMeshes(chunkPositions);
     for (const auto& pos : chunkPositions) {
         renderChunk(pos, shader, sunDirection, sunColor);
     }
 }
 
 void ChunkController::renderChunk(const ChunkPos& pos, Shader& shader, const glm::vec3& sunDirection, const glm::vec3& sunColor) {
-    auto chunkOpt = getChunk(pos);
+    auto chunkOpt = findChunk(pos);
     if (chunkOpt) {
         chunkOpt->get().render(shader, sunDirection, sunColor);
     }
 }
 
-void ChunkController::markChunkDirty(const ChunkPos& pos) {
-    if (getChunk(pos).has_value()) {
-        getChunk(pos).value().get().markChunkDirty();
+void ChunkController::markChunkDirty(const ChunkPos& pos, bool urgent) {
+    if (auto chunkOpt = findChunk(pos)) {
+        chunkOpt->get().markChunkDirty(urgent);
+    }
+}
+
+void ChunkController::updateMeshes(const std::vector<ChunkPos>& chunkPositions) {
+    auto& scheduler = ChunkMeshScheduler::getInstance();
+    const glm::ivec3 center = _lastCenter.value_or(ChunkPos()).position;
+
+    for (const auto& pos : chunkPositions) {
+        auto chunkOpt = findChunk(pos);
+        if (!chunkOpt) continue;
+        // A rebuild reads the blocks, a parked chunk marked dirty comes back for it
+        Chunk& chunk = chunkOpt->get();
+        if (chunk.isParked() && chunk.getMesh().needUpdate) makeResident(chunk);
+        auto job = chunk.takeMeshJob();
+        if (!job) continue;
+
+        const glm::ivec3 offset = glm::abs(pos.position - center);
+        job->distance = std::max({ offset.x, offset.y, offset.z });
+        job->priority = job->priority && job->distance <= MESH_PRIORITY_DISTANCE;
+        scheduler.submit(std::move(job));
+    }
+
+    // A chunk unloaded or recycled since its job was submitted drops the result
+    auto& uploads = ChunkUploadScheduler::getInstance();
+    for (auto& job : scheduler.collect()) {
+        auto chunkOpt = findChunk(job->pos);
+        if (chunkOpt && chunkOpt->get().finishMeshJob(*job)) {
+            uploads.enqueue(job->pos, job->priority);
+        }
+    }
+    uploads.process(*this, ServiceLocator::getCamera());
+}
+
+void ChunkController::remeshAll() {
+    for (auto& [pos, chunk] : getLoadedChunks()) {
+        if (chunk->hasGeometry()) {
+            chunk->markChunkDirty();
+        }
     }
 }
 
@@ -112,6 +345,15 @@ int divFloor(int a, int b) {
     return q;
 }
 
+void ChunkController::remeshNeighborsOfInserted() {
+    // Loader threads only build chunks; faces against a new neighbour are redone here, once per chunk
+    for (const auto& pos : _chunkMemoryContainer->takeInsertedChunks()) {
+        for (const auto& face : faces) {
+            markChunkDirty(ChunkPos(pos.position + face.neighborOffset));
+        }
+    }
+}
+
 ChunkPos ChunkController::toChunkPos(const glm::ivec3& pos) const {
     ChunkPos chunkPos;
     chunkPos.position = glm::ivec3(
@@ -123,7 +365,13 @@ ChunkPos ChunkController::toChunkPos(const glm::ivec3& pos) const {
 }
 
 void ChunkController::update(const glm::ivec3& playerPos, int viewDistance) {
+    _chunkMemoryContainer->dispatchCompletedReads();
+    remeshNeighborsOfInserted();
+
     auto center = toChunkPos(playerPos);
+    Chunk::advanceAccessClock();
+    parkIdleChunks(center);
+
     auto prevPos = _lastCenter;
     if (_lastCenter.has_value()) {
         if (_lastCenter.value() == center) {
@@ -146,6 +394,10 @@ void ChunkController::update(const glm::ivec3& playerPos, int viewDistance) {
 }
 
 void ChunkController::initWorld(glm::vec3 playerPos, int viewDistance) {
+    RegionStorage::getInstance().convertLegacyChunks(worldName);
+    RegionStorage::getInstance().openWorld(worldName);
+    ChunkMeshCache::getInstance().open(worldName);
+
     auto center = toChunkPos(playerPos);
 
     std::vector<ChunkPos> initialChunks;
@@ -0,0 +1,165 @@
+#include "ChunkIndex.h"
+#include "PathProvider.h"
+#include "Logger.h"
+
+#include <bit>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+namespace {
+    constexpr uint32_t INDEX_MAGIC = 0x49434F4D; // "MOCI"
+    constexpr uint32_t INDEX_VERSION = 1;
+}
+
+ChunkIndex::ChunkIndex(const std::string& worldName)
+    : _path(PathProvider::getInstance().getChunkIndexPath(worldName)),
+      _regionsPath(PathProvider::getInstance().getWorldRegionsPath(worldName)) {
+    if (load()) return;
+
+    rebuild();
+    Logger::getInstance().Log(
+        "Rebuilt chunk index of world '" + worldName + "': " + std::to_string(_count) +
+        " chunks in " + std::to_string(_regions.size()) + " regions",
+        LogLevel::Info
+    );
+    save();
+}
+
+void ChunkIndex::set(const ChunkPos& pos, bool saved) {
+    std::unique_lock lock(_mutex);
+    const int index = RegionFile::toLocalIndex(pos);
+    const uint64_t bit = uint64_t(1) << (index & 63);
+
+    auto it = _regions.find(ChunkPos(RegionFile::toRegionPos(pos)));
+    if (it == _regions.end()) {
+        if (!saved) return;
+        it = _regions.emplace(ChunkPos(RegionFile::toRegionPos(pos)), RegionFile::PresenceMask{}).first;
+    }
+    uint64_t& word = it->second[index >> 6];
+    if (((word & bit) != 0) == saved) return;
+
+    word ^= bit;
+    saved ? ++_count : --_count;
+
+    if (_fileCurrent) {
+        std::error_code ec;
+        fs::remove(_path, ec);
+        _fileCurrent = false;
+    }
+}
+
+void ChunkIndex::setRegion(const glm::ivec3& regionPos, const RegionFile::PresenceMask& mask) {
+    std::unique_lock lock(_mutex);
+    size_t count = 0;
+    for (uint64_t word : mask) count += std::popcount(word);
+
+    auto it = _regions.find(ChunkPos(regionPos));
+    if (it != _regions.end()) {
+        if (it->second == mask) return;
+        for (uint64_t word : it->second) _count -= std::popcount(word);
+        if (count > 0) it->second = mask;
+        else _regions.erase(it);
+    } else {
+        if (count == 0) return;
+        _regions.emplace(ChunkPos(regionPos), mask);
+    }
+    _count += count;
+
+    if (_fileCurrent) {
+        std::error_code ec;
+        fs::remove(_path, ec);
+        _fileCurrent = false;
+    }
+}
+
+bool ChunkIndex::save() {
+    std::unique_lock lock(_mutex);
+    if (_fileCurrent) return true;
+
+    std::error_code ec;
+    fs::create_directories(_path.parent_path(), ec);
+
+    // Written next to the index and renamed over it, a partial file is never read back
+    fs::path tmpPath = _path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) return false;
+
+        const uint32_t header[3] = { INDEX_MAGIC, INDEX_VERSION, static_cast<uint32_t>(_regions.size()) };
+        ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const auto& [regionPos, mask] : _regions) {
+            const int32_t coords[3] = { regionPos.position.x, regionPos.position.y, regionPos.position.z };
+            ofs.write(reinterpret_cast<const char*>(coords), sizeof(coords));
+            ofs.write(reinterpret_cast<const char*>(mask.data()), sizeof(mask));
+        }
+        if (!ofs.good()) {
+            Logger::getInstance().Log("Failed to write chunk index: " + _path.string(), LogLevel::Warning);
+            return false;
+        }
+    }
+
+    fs::rename(tmpPath, _path, ec);
+    if (ec) return false;
+    _fileCurrent = true;
+    return true;
+}
+
+bool ChunkIndex::load() {
+    std::ifstream ifs(_path, std::ios::binary);
+    if (!ifs.is_open()) return false;
+
+    uint32_t header[3] = {};
+    ifs.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!ifs.good() || header[0] != INDEX_MAGIC || header[1] != INDEX_VERSION) return false;
+
+    std::unordered_map<ChunkPos, RegionFile::PresenceMask> regions;
+    size_t count = 0;
+    for (uint32_t i = 0; i < header[2]; ++i) {
+        int32_t coords[3];
+        RegionFile::PresenceMask mask;
+        ifs.read(reinterpret_cast<char*>(coords), sizeof(coords));
+        ifs.read(reinterpret_cast<char*>(mask.data()), sizeof(mask));
+        if (!ifs.good()) return false;
+
+        for (uint64_t word : mask) count += std::popcount(word);
+        regions.emplace(ChunkPos(coords[0], coords[1], coords[2]), mask);
+    }
+
+    _regions = std::move(regions);
+    _count = count;
+    _fileCurrent = true;
+    return true;
+}
+
+void ChunkIndex::rebuild() {
+    _regions.clear();
+    _count = 0;
+    _fileCurrent = false;
+
+    std::error_code ec;
+    if (!fs::is_directory(_regionsPath, ec)) return;
+
+    for (const auto& entry : fs::directory_iterator(_regionsPath, ec)) {
+        if (!entry.is_regular_file()) continue;
+
+        // Region_x_y_z, see PathProvider::getRegionFilePath
+        std::string name = entry.path().filename().string();
+        if (name.rfind("Region_", 0) != 0) continue;
+        std::istringstream iss(name.substr(7));
+        int x, y, z;
+        char sep1, sep2;
+        if (!(iss >> x >> sep1 >> y >> sep2 >> z) || sep1 != '_' || sep2 != '_' || !iss.eof()) continue;
+
+        RegionFile::PresenceMask mask;
+        if (!RegionFile::readPresence(entry.path(), mask)) continue;
+
+        size_t chunks = 0;
+        for (uint64_t word : mask) chunks += std::popcount(word);
+        if (chunks == 0) continue;
+
+        _regions.emplace(ChunkPos(x, y, z), mask);
+        _count += chunks;
+    }
+}
@@ -1,5 +1,9 @@
 #include "ChunkMemoryContainer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
 std::optional<std::reference_wrapper<Chunk>> ChunkMemoryContainer::getChunk(const ChunkPos& pos) const {
     std::shared_lock lock(_mutex);
     auto it = _chunks.find(pos);
@@ -8,29 +12,50 @@ std::optional<std::reference_wrapper<Chunk>> ChunkMemoryContainer::getChunk(cons
 }
 
 void ChunkMemoryContainer::removeChunk(const ChunkPos& pos) {
-    std::unique_lock lock(_mutex);
-    _chunks.erase(pos);
+    std::unique_ptr<Chunk> removed;
+    {
+        std::unique_lock lock(_mutex);
+        auto node = _chunks.extract(pos);
+        if (!node.empty()) removed = std::move(node.mapped());
+    }
+    ChunkPool::getInstance().release(std::move(removed));
 }
 
 void ChunkMemoryContainer::loadChunk(const ChunkPos& pos, std::unique_ptr<Chunk> chunk) {
-    std::unique_lock lock(_mutex);
-    auto [_, inserted] = _chunks.emplace(pos, std::move(chunk));
-    if (!inserted) {
-        Logger::getInstance().Log(
-            "Chunk already loaded at position: " + pos.toString(),
-            LogLevel::Warning
-        );
+    {
+        std::unique_lock lock(_mutex);
+        auto [_, inserted] = _chunks.try_emplace(pos, std::move(chunk));
+        if (inserted) return;
     }
+    Logger::getInstance().Log(
+        "Chunk already loaded at position: " + pos.toString(),
+        LogLevel::Warning
+    );
+    ChunkPool::getInstance().release(std::move(chunk));
 }
 
 void ChunkMemoryContainer::unloadChunk(const ChunkPos& pos) {
-    std::unique_lock lock(_mutex);
-    if (_chunks.erase(pos) == 0) {
+    std::unique_ptr<Chunk> removed;
+    {
+        std::unique_lock lock(_mutex);
+        auto node = _chunks.extract(pos);
+        if (!node.empty()) removed = std::move(node.mapped());
+    }
+    if (!removed) {
         Logger::getInstance().Log(
             "Chunk not found at position: " + pos.toString(),
             LogLevel::Warning
         );
+        return;
     }
+    ChunkPool::getInstance().release(std::move(removed));
+}
+
+std::vector<ChunkPos> ChunkMemoryContainer::takeInsertedChunks() {
+    std::vector<ChunkPos> inserted;
+    std::unique_lock lock(_mutex);
+    inserted.swap(_inserted);
+    return inserted;
 }
 
 std::vector<ChunkPos> ChunkMemoryContainer::getLoadedChunksPosition() const {
@@ -59,31 +84,26 @@ void ChunkMemoryContainer::removeUnlistedChunks(
         }
     }
 
-    const size_t batchSize = 32;
+    // Unlisting and snapshotting happen here, on the thread that edits chunks.
+    // Clean chunks are already on disk or queued, only dirty ones are saved.
+    std::vector<std::unique_ptr<Chunk>> unlisted;
+    unlisted.reserve(toRemove.size());
 
-    for (size_t i = 0; i < toRemove.size(); i += batchSize) {
-        size_t end = std::min(i + batchSize, toRemove.size());
-        std::vector<ChunkPos> batch(toRemove.begin() + i, toRemove.begin() + end);
-
-        ThreadPool::getInstance().enqueueChunkTask([this, batch, worldName]() {
-            for (const auto& pos : batch) {
-                std::unique_ptr<Chunk> chunkToSave;
-
-                {
-                    std::unique_lock lock(_mutex);
-                    auto found = _chunks.find(pos);
-                    if (found != _chunks.end()) {
-                        found->second->markSavingStarted();
-                        chunkToSave = std::move(found->second);
-                        _chunks.erase(found);
-                    }
-                }
+    {
+        std::unique_lock lock(_mutex);
+        for (const auto& pos : toRemove) {
+            auto node = _chunks.extract(pos);
+            if (!node.empty()) unlisted.push_back(std::move(node.mapped()));
+        }
+    }
 
-                if (chunkToSave) {
-                    _chunkLoader.saveChunk(pos, *chunkToSave, worldName);
-                }
-            }
-        });
+    for (auto& chunk : unlisted) {
+        if (chunk->isDirty()) {
+            ChunkSnapshot snapshot = chunk->snapshot();
+            chunk->markSaved(snapshot.version);
+            ChunkSaver::getInstance().schedule(std::move(snapshot), worldName);
+        }
+        ChunkPool::getInstance().release(std::move(chunk));
     }
 }
 
@@ -101,46 +121,139 @@ void ChunkMemoryContainer::loadVectorOfChunks(const std::vector<ChunkPos>& chunk
     }
 
     const size_t batchSize = 32;
-
-    for (size_t i = 0; i < toLoad.size(); i += batchSize) {
-        std::vector<std::pair<ChunkPos, bool>> batch;
-        size_t end = std::min(i + batchSize, toLoad.size());
-
-        for (size_t j = i; j < end; ++j) {
-            const auto& chunkPos = toLoad[j];
-            bool exists = FileHandler::getInstance().fileExists(
-                PathProvider::getInstance().getChunkFilePath(worldName, chunkPos)
-            );
-            batch.emplace_back(chunkPos, exists);
+    std::vector<std::pair<ChunkPos, bool>> batch;
+    std::vector<AsyncRead> reads;
+    RegionChunkLocation location;
+
+    auto enqueueBatch = [&]() {
+        if (batch.empty()) return;
+        std::function<void()> work = [this, batch, worldName] { loadBatch(batch, worldName); };
+        enqueueLoadTask(std::move(work), std::move(batch), worldName);
+        batch.clear();
+    };
+
+    for (const auto& chunkPos : toLoad) {
+        bool exists = _chunkLoader.chunkExists(chunkPos, worldName);
+
+        // Stored payloads go through AsyncFileIO: many reads in flight and no worker waits on
+        // the disk. Pending saves and inline payloads are already in memory.
+        if (exists && !ChunkSaver::getInstance().hasPending(chunkPos) &&
+            RegionStorage::getInstance().locate(worldName, chunkPos, location) && location.inlineBytes.empty()) {
+            reads.push_back(AsyncRead{ location.path, location.offset, location.length,
+                [this, chunkPos, worldName](bool ok, std::string bytes) {
+                    std::lock_guard<std::mutex> lock(_readsMutex);
+                    _completedReads.push_back(CompletedRead{ chunkPos, worldName, ok, std::move(bytes) });
+                } });
+            continue;
         }
 
-        ThreadPool::getInstance().enqueueChunkTask([this, batch = std::move(batch), worldName]() mutable {
-            for (auto& [chunkPos, exists] : batch) {
-                std::unique_ptr<Chunk> chunk;
+        batch.emplace_back(chunkPos, exists);
+        if (batch.size() == batchSize) enqueueBatch();
+    }
+    enqueueBatch();
+    AsyncFileIO::getInstance().submitReads(std::move(reads));
 
-                if (exists) {
-                    chunk = _chunkLoader.loadChunk(chunkPos, worldName);
-                } else {
-                    chunk = _chunkLoader.generateChunk(chunkPos);
-                }
+    removeUnlistedChunks(chunksPos, worldName);
+}
 
-                {
-                    std::unique_lock lock(_mutex);
+void ChunkMemoryContainer::dispatchCompletedReads() {
+    reapLoadTasks();
 
-                    if (chunk) {
-                        auto [_, inserted] = _chunks.emplace(chunkPos, std::move(chunk));
-                        if (!inserted) {
-                            Logger::getInstance().Log("Chunk already loaded", LogLevel::Warning);
-                        }
-                    }
+    std::vector<CompletedRead> completed;
+    {
+        std::lock_guard<std::mutex> lock(_readsMutex);
+        completed.swap(_completedReads);
+    }
 
-                    _loadingSet.erase(chunkPos);
+    const size_t batchSize = 32;
+    for (size_t i = 0; i < completed.size(); i += batchSize) {
+        const size_t end = std::min(i + batchSize, completed.size());
+        std::vector<CompletedRead> batch(std::make_move_iterator(completed.begin() + i),
+                                         std::make_move_iterator(completed.begin() + end));
+        // Dropped unrun, the chunks are read again from their regions
+        LoadBatch positions;
+        for (const auto& read : batch) positions.emplace_back(read.pos, true);
+        const std::string worldName = batch.front().worldName;
+
+        enqueueLoadTask([this, batch = std::move(batch)]() mutable {
+            for (auto& read : batch) {
+                std::unique_ptr<Chunk> chunk;
+                // A save queued since the read was submitted is newer than the bytes read
+                if (read.ok && !ChunkSaver::getInstance().hasPending(read.pos)) {
+                    chunk = _chunkLoader.loadChunkFromBytes(read.pos, read.bytes, read.worldName);
                 }
+                if (!chunk) {
+                    chunk = _chunkLoader.loadChunk(read.pos, read.worldName);
+                }
+                finishLoading(read.pos, std::move(chunk));
             }
-        });
+        }, std::move(positions), worldName);
     }
+}
 
-    removeUnlistedChunks(chunksPos, worldName);
+void ChunkMemoryContainer::loadBatch(const LoadBatch& batch, const std::string& worldName) {
+    for (const auto& [chunkPos, exists] : batch) {
+        if (exists) {
+            finishLoading(chunkPos, _chunkLoader.loadChunk(chunkPos, worldName));
+        } else {
+            finishLoading(chunkPos, _chunkLoader.generateChunk(chunkPos, worldName));
+        }
+    }
+}
+
+void ChunkMemoryContainer::enqueueLoadTask(std::function<void()> work, LoadBatch batch, const std::string& worldName) {
+    try {
+        _loadTasks.push_back(LoadTask{ ThreadPool::getInstance().enqueueChunkTask(std::move(work)), std::move(batch), worldName });
+    } catch (const std::runtime_error&) {
+        // Pool stopping: nothing will load these, clear their marks
+        for (const auto& [pos, exists] : batch) finishLoading(pos, nullptr);
+    }
+}
+
+void ChunkMemoryContainer::reapLoadTasks() {
+    std::vector<LoadTask> dropped;
+    for (auto it = _loadTasks.begin(); it != _loadTasks.end();) {
+        if (it->done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        try {
+            it->done.get();
+        } catch (const std::future_error&) {
+            dropped.push_back(std::move(*it));
+        } catch (const std::exception& e) {
+            // Chunks the task did not get to would stay marked as loading
+            Logger::getInstance().Log(std::string("Chunk load task failed: ") + e.what(), LogLevel::Error);
+            for (const auto& [pos, exists] : it->batch) finishLoading(pos, nullptr);
+        }
+        it = _loadTasks.erase(it);
+    }
+
+    for (auto& task : dropped) {
+        std::function<void()> work = [this, batch = task.batch, worldName = task.worldName] {
+            loadBatch(batch, worldName);
+        };
+        enqueueLoadTask(std::move(work), std::move(task.batch), task.worldName);
+    }
+}
+
+void ChunkMemoryContainer::finishLoading(const ChunkPos& pos, std::unique_ptr<Chunk> chunk) {
+    bool inserted = true;
+    {
+        std::unique_lock lock(_mutex);
+
+        if (chunk) {
+            inserted = _chunks.try_emplace(pos, std::move(chunk)).second;
+            if (inserted) _inserted.push_back(pos);
+        }
+
+        _loadingSet.erase(pos);
+    }
+
+    if (!inserted) {
+        Logger::getInstance().Log("Chunk already loaded", LogLevel::Warning);
+        ChunkPool::getInstance().release(std::move(chunk));
+    }
 }
 
 void ChunkMemoryContainer::loadInitialChunksBlocking(const std::vector<ChunkPos>& chunksPos, const std::string& worldName) {
@@ -158,51 +271,41 @@ void ChunkMemoryContainer::loadInitialChunksBlocking(const std::vector<ChunkPos>
 
     const size_t batchSize = 10;
 
+    std::vector<LoadBatch> batches;
     std::vector<std::future<void>> futures;
 
     for (size_t i = 0; i < toLoad.size(); i += batchSize) {
-        std::vector<std::pair<ChunkPos, bool>> batch;
+        LoadBatch batch;
         size_t end = std::min(i + batchSize, toLoad.size());
 
         for (size_t j = i; j < end; ++j) {
             const auto& chunkPos = toLoad[j];
-            bool exists = FileHandler::getInstance().fileExists(
-                PathProvider::getInstance().getChunkFilePath(worldName, chunkPos)
-            );
+            bool exists = _chunkLoader.chunkExists(chunkPos, worldName);
             batch.emplace_back(chunkPos, exists);
         }
 
-        auto fut = ThreadPool::getInstance().enqueueChunkTask([this, batch = std::move(batch), worldName]() mutable {
-            for (auto& [chunkPos, exists] : batch) {
-                std::unique_ptr<Chunk> chunk;
-
-                if (exists) {
-                    chunk = _chunkLoader.loadChunk(chunkPos, worldName);
-                } else {
-                    chunk = _chunkLoader.generateChunk(chunkPos);
-                }
-
-                {
-                    std::unique_lock lock(_mutex);
-
-                    if (chunk) {
-                        auto [_, inserted] = _chunks.emplace(chunkPos, std::move(chunk));
-                        if (!inserted) {
-                            Logger::getInstance().Log("Chunk already loaded", LogLevel::Warning);
-                        }
-                    }
-
-                    _loadingSet.erase(chunkPos);
-                }
-            }
-        });
-
-        futures.push_back(std::move(fut));
+        batches.push_back(std::move(batch));
+        try {
+            futures.push_back(ThreadPool::getInstance().enqueueChunkTask([this, batch = batches.back(), worldName] {
+                loadBatch(batch, worldName);
+            }));
+        } catch (const std::runtime_error&) {
+            futures.emplace_back();
+        }
     }
 
     removeUnlistedChunks(chunksPos, worldName);
 
-    for (auto& fut : futures) {
-        fut.get();
+    for (size_t b = 0; b < futures.size(); ++b) {
+        // Pool stopping, or the task was pushed out of a full queue: load the batch here
+        if (!futures[b].valid()) {
+            loadBatch(batches[b], worldName);
+            continue;
+        }
+        try {
+            futures[b].get();
+        } catch (const std::future_error&) {
+            loadBatch(batches[b], worldName);
+        }
     }
 }
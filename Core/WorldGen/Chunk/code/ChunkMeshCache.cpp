@@ -0,0 +1,289 @@
+#include "ChunkMeshCache.h"
+#include "PathProvider.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x48534D4D;  // "MMSH"
+constexpr size_t HEADER_SIZE = 4 + 4 + 8 + 4 + 4;
+
+static_assert(sizeof(Vertex) == 12 * sizeof(float), "cached vertices are copied as raw floats");
+
+template<typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T get(const std::string& in, size_t offset) {
+    T value;
+    std::memcpy(&value, in.data() + offset, sizeof(T));
+    return value;
+}
+
+bool readFile(const fs::path& path, std::string& bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
+ChunkMeshCache::ChunkMeshCache() {
+    _thread = std::thread(&ChunkMeshCache::run, this);
+}
+
+ChunkMeshCache::~ChunkMeshCache() {
+    shutdown();
+}
+
+void ChunkMeshCache::open(const std::string& worldName) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    waitForWriter(lock);
+
+    _folder = PathProvider::getInstance().getWorldMeshCachePath(worldName);
+    _lru.clear();
+    _entries.clear();
+    _bytes = 0;
+
+    std::error_code ec;
+    fs::create_directories(_folder, ec);
+
+    struct Found {
+        fs::file_time_type time;
+        ChunkPos pos;
+        uint64_t bytes;
+        uint64_t key;
+    };
+    std::vector<Found> found;
+    for (const auto& file : fs::directory_iterator(_folder, ec)) {
+        ChunkPos pos;
+        if (!file.is_regular_file(ec) || !parseFileName(file.path(), pos)) continue;
+        // Only the header is read here, load() compares keys without opening the file
+        uint64_t key = 0;
+        if (!readKey(file.path(), key)) {
+            _removals.push_back(file.path());
+            continue;
+        }
+        found.push_back(Found{ file.last_write_time(ec), pos, file.file_size(ec), key });
+    }
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.time < b.time; });
+    for (const auto& f : found) {
+        touch(f.pos, f.bytes, f.key);
+    }
+    evictOverflow();
+    if (!_removals.empty()) _wake.notify_one();
+}
+
+bool ChunkMeshCache::load(const ChunkPos& pos, uint64_t key, std::vector<Vertex>& vertices,
+                          std::vector<unsigned int>& indices) {
+    if (!isEnabled()) return false;
+
+    fs::path path;
+    std::string bytes;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.lookups;
+        auto entry = _entries.find(pos);
+        if (entry == _entries.end() || entry->second.key != key) return false;
+
+        if (auto pending = _pending.find(pos); pending != _pending.end()) {
+            bytes = pending->second.bytes;
+        }
+        path = pathFor(pos);
+    }
+
+    const bool fromDisk = bytes.empty();
+    if (fromDisk && !readFile(path, bytes)) return false;
+    if (!decode(bytes, key, vertices, indices)) return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.hits;
+    if (auto entry = _entries.find(pos); entry != _entries.end()) {
+        touch(pos, entry->second.bytes, entry->second.key);
+    }
+    if (fromDisk) {
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    }
+    return true;
+}
+
+void ChunkMeshCache::store(const ChunkPos& pos, uint64_t key, const std::vector<Vertex>& vertices,
+                           const std::vector<unsigned int>& indices) {
+    if (!isEnabled() || vertices.empty()) return;
+    std::string bytes = encode(key, vertices, indices);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopping || _folder.empty()) return;
+    ++_stats.stores;
+
+    touch(pos, bytes.size(), key);
+    _pending[pos] = PendingMesh{ pathFor(pos), std::move(bytes) };
+    evictOverflow();
+    _wake.notify_one();
+}
+
+void ChunkMeshCache::shutdown() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_stopping) return;
+        waitForWriter(lock);
+        _stopping = true;
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+ChunkMeshCacheStats ChunkMeshCache::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ChunkMeshCacheStats stats = _stats;
+    stats.entries = _entries.size();
+    stats.bytes = _bytes;
+    return stats;
+}
+
+fs::path ChunkMeshCache::pathFor(const ChunkPos& pos) const {
+    return _folder / (std::to_string(pos.position.x) + "_" + std::to_string(pos.position.y) + "_" +
+                      std::to_string(pos.position.z) + ".mesh");
+}
+
+bool ChunkMeshCache::parseFileName(const fs::path& path, ChunkPos& pos) {
+    if (path.extension() != ".mesh") return false;
+    int x, y, z;
+    char tail;
+    if (std::sscanf(path.stem().string().c_str(), "%d_%d_%d%c", &x, &y, &z, &tail) != 3) return false;
+    pos = ChunkPos(x, y, z);
+    return true;
+}
+
+bool ChunkMeshCache::readKey(const fs::path& path, uint64_t& key) {
+    std::ifstream file(path, std::ios::binary);
+    std::string header(16, '\0');
+    if (!file.read(header.data(), static_cast<std::streamsize>(header.size()))) return false;
+    if (get<uint32_t>(header, 0) != MAGIC || get<uint32_t>(header, 4) != FORMAT_VERSION) return false;
+    key = get<uint64_t>(header, 8);
+    return true;
+}
+
+// u32 magic | u32 format version | u64 key | u32 vertex count | u32 index count | vertices | indices
+std::string ChunkMeshCache::encode(uint64_t key, const std::vector<Vertex>& vertices,
+                                   const std::vector<unsigned int>& indices) {
+    std::string out;
+    out.reserve(HEADER_SIZE + vertices.size() * sizeof(Vertex) + indices.size() * sizeof(uint32_t));
+    put<uint32_t>(out, MAGIC);
+    put<uint32_t>(out, FORMAT_VERSION);
+    put<uint64_t>(out, key);
+    put<uint32_t>(out, static_cast<uint32_t>(vertices.size()));
+    put<uint32_t>(out, static_cast<uint32_t>(indices.size()));
+    out.append(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+    for (unsigned int index : indices) {
+        put<uint32_t>(out, static_cast<uint32_t>(index));
+    }
+    return out;
+}
+
+bool ChunkMeshCache::decode(const std::string& bytes, uint64_t key, std::vector<Vertex>& vertices,
+                            std::vector<unsigned int>& indices) {
+    if (bytes.size() < HEADER_SIZE) return false;
+    if (get<uint32_t>(bytes, 0) != MAGIC || get<uint32_t>(bytes, 4) != FORMAT_VERSION) return false;
+    if (get<uint64_t>(bytes, 8) != key) return false;
+
+    const uint64_t vertexCount = get<uint32_t>(bytes, 16);
+    const uint64_t indexCount = get<uint32_t>(bytes, 20);
+    if (bytes.size() != HEADER_SIZE + vertexCount * sizeof(Vertex) + indexCount * sizeof(uint32_t)) return false;
+
+    vertices.resize(vertexCount);
+    std::memcpy(vertices.data(), bytes.data() + HEADER_SIZE, vertexCount * sizeof(Vertex));
+    indices.resize(indexCount);
+    const size_t indexStart = HEADER_SIZE + vertexCount * sizeof(Vertex);
+    for (size_t i = 0; i < indexCount; ++i) {
+        indices[i] = get<uint32_t>(bytes, indexStart + i * sizeof(uint32_t));
+        if (indices[i] >= vertexCount) return false;
+    }
+    return true;
+}
+
+void ChunkMeshCache::touch(const ChunkPos& pos, uint64_t bytes, uint64_t key) {
+    auto it = _entries.find(pos);
+    if (it == _entries.end()) {
+        _lru.push_front(pos);
+        _entries.emplace(pos, Entry{ _lru.begin(), bytes, key });
+        _bytes += bytes;
+        return;
+    }
+    _lru.splice(_lru.begin(), _lru, it->second.lru);
+    _bytes = _bytes - it->second.bytes + bytes;
+    it->second.bytes = bytes;
+    it->second.key = key;
+}
+
+void ChunkMeshCache::evictOverflow() {
+    while (_bytes > MAX_BYTES && !_lru.empty()) {
+        const ChunkPos pos = _lru.back();
+        _lru.pop_back();
+        auto it = _entries.find(pos);
+        _bytes -= it->second.bytes;
+        _entries.erase(it);
+        _pending.erase(pos);
+        _removals.push_back(pathFor(pos));
+        ++_stats.evictions;
+    }
+}
+
+void ChunkMeshCache::waitForWriter(std::unique_lock<std::mutex>& lock) {
+    _wake.notify_one();
+    _drained.wait(lock, [this] { return _pending.empty() && _removals.empty() && !_writing; });
+}
+
+void ChunkMeshCache::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _wake.wait(lock, [this] { return _stopping || !_pending.empty() || !_removals.empty(); });
+        if (_pending.empty() && _removals.empty()) {
+            if (_stopping) return;
+            continue;
+        }
+
+        // Removals first: a chunk evicted and stored again in one batch keeps the new file
+        std::vector<fs::path> removals = std::move(_removals);
+        _removals.clear();
+        std::unordered_map<ChunkPos, PendingMesh> batch = std::move(_pending);
+        _pending.clear();
+        _writing = true;
+        lock.unlock();
+
+        std::error_code ec;
+        for (const auto& path : removals) {
+            fs::remove(path, ec);
+        }
+        for (const auto& [pos, mesh] : batch) {
+            fs::path tmp = mesh.path;
+            tmp += ".tmp";
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            file.write(mesh.bytes.data(), static_cast<std::streamsize>(mesh.bytes.size()));
+            file.close();
+            if (!file.good()) {
+                Logger::getInstance().Log("Mesh cache write failed: " + mesh.path.string(), LogLevel::Warning);
+                fs::remove(tmp, ec);
+                continue;
+            }
+            fs::rename(tmp, mesh.path, ec);
+        }
+
+        lock.lock();
+        _writing = false;
+        if (_pending.empty() && _removals.empty()) {
+            _drained.notify_all();
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include "ChunkMeshScheduler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+bool fartherThan(const std::unique_ptr<ChunkMeshJob>& a, const std::unique_ptr<ChunkMeshJob>& b) {
+    return a->distance > b->distance;
+}
+
+} // namespace
+
+void ChunkMeshScheduler::submit(std::unique_ptr<ChunkMeshJob> job) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopping) return;
+    if (job->priority) {
+        _priority.push_back(std::move(job));
+        return;
+    }
+    _queued.push_back(std::move(job));
+    std::push_heap(_queued.begin(), _queued.end(), fartherThan);
+}
+
+std::vector<std::unique_ptr<ChunkMeshJob>> ChunkMeshScheduler::collect() {
+    auto& pool = ThreadPool::getInstance();
+    reapRunners();
+
+    // At most one waiting task per worker, each takes jobs for a time slice
+    size_t toStart = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) return {};
+        const size_t wanted = std::min(_queued.size() + _priority.size(), pool.getWorkerCount());
+        toStart = wanted > _runnersWaiting ? wanted - _runnersWaiting : 0;
+        _runnersWaiting += toStart;
+    }
+    for (size_t i = 0; i < toStart; ++i) {
+        try {
+            _runners.push_back(pool.enqueueChunkTask([this] { runQueued(); }));
+        } catch (const std::runtime_error&) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_runnersWaiting;
+        }
+    }
+
+    // Priority jobs no worker has started are built here, the others are waited for
+    for (;;) {
+        std::unique_ptr<ChunkMeshJob> job;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            job = takeNext(true);
+        }
+        if (!job) break;
+        ChunkMeshBuilder::run(*job);
+        finish(std::move(job));
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _priorityDone.wait(lock, [this] { return _priorityRunning == 0; });
+    return std::exchange(_finished, {});
+}
+
+void ChunkMeshScheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        _priority.clear();
+        _queued.clear();
+    }
+    // Each runner either starts and finds nothing queued or is pushed out of the ThreadPool
+    // queue, which breaks its future; either way it is ready without waiting on a timeout
+    for (auto& runner : _runners) runner.wait();
+    reapRunners();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this] { return _running == 0; });
+    _finished.clear();
+}
+
+ChunkMeshSchedulerStats ChunkMeshScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ChunkMeshSchedulerStats stats;
+    stats.queued = _queued.size() + _priority.size();
+    stats.running = _running;
+    return stats;
+}
+
+std::unique_ptr<ChunkMeshJob> ChunkMeshScheduler::takeNext(bool priorityOnly) {
+    std::unique_ptr<ChunkMeshJob> job;
+    if (!_priority.empty()) {
+        job = std::move(_priority.back());
+        _priority.pop_back();
+        ++_priorityRunning;
+    } else if (!priorityOnly && !_queued.empty()) {
+        std::pop_heap(_queued.begin(), _queued.end(), fartherThan);
+        job = std::move(_queued.back());
+        _queued.pop_back();
+    }
+    if (job) ++_running;
+    return job;
+}
+
+void ChunkMeshScheduler::finish(std::unique_ptr<ChunkMeshJob> job) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_running;
+    if (job->priority && --_priorityRunning == 0) {
+        _priorityDone.notify_all();
+    }
+    if (_running == 0) _idle.notify_all();
+    _finished.push_back(std::move(job));
+}
+
+void ChunkMeshScheduler::reapRunners() {
+    size_t dropped = 0;
+    std::erase_if(_runners, [&](std::future<void>& runner) {
+        if (runner.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+        try {
+            runner.get();
+        } catch (const std::future_error&) {
+            ++dropped;
+        }
+        return true;
+    });
+    if (dropped == 0) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _runnersWaiting -= dropped;
+}
+
+void ChunkMeshScheduler::runQueued() {
+    const auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_runnersWaiting == 0 && _running == 0) _idle.notify_all();
+    }
+
+    while (std::chrono::steady_clock::now() - start < RUNNER_TIME_SLICE) {
+        std::unique_ptr<ChunkMeshJob> job;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            job = takeNext(false);
+        }
+        if (!job) return;
+        ChunkMeshBuilder::run(*job);
+        finish(std::move(job));
+    }
+}
@@ -0,0 +1,364 @@
+#include "ChunkMesher.h"
+#include "BlockCache.h"
+#include "BlockFace.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr int S = ChunkMeshSource::SIZE;
+constexpr int ROWS = S * S;
+
+// One 32-bit mask per (y, z) row, bit x, in ChunkBlocksOpaqueData row order
+using RowMasks = std::array<uint32_t, ROWS>;
+
+// How a face lies in its plane, in BlockFace.h order: the axis of the normal, then the
+// axes and directions of the quad's first edge (vertex 0 -> 1, texture u) and second
+// edge (1 -> 2, texture v), matching the baked quads so merged and single faces agree.
+struct FacePlane {
+    int normalAxis;
+    bool positive;
+    int uAxis;
+    int uSign;
+    int vAxis;
+    int vSign;
+};
+
+constexpr FacePlane facePlanes[6] = {
+    { 0, true,  2, +1, 1, +1 },  // east
+    { 0, false, 2, -1, 1, +1 },  // west
+    { 1, true,  0, +1, 2, +1 },  // up
+    { 1, false, 0, +1, 2, -1 },  // down
+    { 2, true,  0, -1, 1, +1 },  // south
+    { 2, false, 0, +1, 1, +1 },  // north
+};
+
+struct MeshOut {
+    std::vector<Vertex>& vertices;
+    std::vector<unsigned int>& indices;
+};
+
+// Only face neighbours are asked for, so at most one coordinate is outside the chunk
+bool isOpaque(const ChunkMeshSource& source, const glm::ivec3& p) {
+    if (p.x < 0)  return (source.borders[1][p.z] >> p.y) & 1u;
+    if (p.x >= S) return (source.borders[0][p.z] >> p.y) & 1u;
+    if (p.y < 0)  return (source.borders[3][p.z] >> p.x) & 1u;
+    if (p.y >= S) return (source.borders[2][p.z] >> p.x) & 1u;
+    if (p.z < 0)  return (source.borders[5][p.y] >> p.x) & 1u;
+    if (p.z >= S) return (source.borders[4][p.y] >> p.x) & 1u;
+    return source.opacity->isOpaque(p.x, p.y, p.z);
+}
+
+void addQuad(MeshOut& out, const glm::vec3* quadVerts, const glm::vec3& normal,
+             const glm::vec2* tileUVs, const glm::vec4& atlasRect) {
+    const unsigned int start = out.vertices.size();
+    const Vertex quad[4] = {
+        { quadVerts[0], normal, tileUVs[0], atlasRect },
+        { quadVerts[1], normal, tileUVs[1], atlasRect },
+        { quadVerts[2], normal, tileUVs[2], atlasRect },
+        { quadVerts[3], normal, tileUVs[3], atlasRect }
+    };
+    out.vertices.insert(out.vertices.end(), quad, quad + 4);
+    const unsigned int quadIndices[6] = { start, start + 2, start + 1, start, start + 3, start + 2 };
+    out.indices.insert(out.indices.end(), quadIndices, quadIndices + 6);
+}
+
+// A baked model face of the block at worldBlockPos
+void addBakedQuad(MeshOut& out, const glm::ivec3& worldBlockPos, const BakedQuad& quad) {
+    const glm::vec3 offset(worldBlockPos);
+    const glm::vec3 verts[4] = { quad.vertices[0] + offset, quad.vertices[1] + offset,
+                                 quad.vertices[2] + offset, quad.vertices[3] + offset };
+    addQuad(out, verts, quad.normal, quad.uvs, quad.atlasRect);
+}
+
+// The quad covering cells [u, u + w) x [v, v + h) of the plane at slice, texture repeated w x h times
+void addMergedQuad(MeshOut& out, const glm::ivec3& chunkOrigin, int face, int slice,
+                   int u, int v, int w, int h, const BakedQuad& quad) {
+    const FacePlane& plane = facePlanes[face];
+    auto corner = [&](int cu, int cv) {
+        glm::ivec3 p;
+        p[plane.normalAxis] = slice + (plane.positive ? 1 : 0);
+        p[plane.uAxis] = cu;
+        p[plane.vAxis] = cv;
+        return glm::vec3(chunkOrigin + p);
+    };
+
+    const int uStart = plane.uSign > 0 ? u : u + w;
+    const int uEnd   = plane.uSign > 0 ? u + w : u;
+    const int vStart = plane.vSign > 0 ? v : v + h;
+    const int vEnd   = plane.vSign > 0 ? v + h : v;
+
+    const glm::vec3 verts[4] = { corner(uStart, vStart), corner(uEnd, vStart), corner(uEnd, vEnd), corner(uStart, vEnd) };
+    const glm::vec2 tileUVs[4] = { { 0, 0 }, { w, 0 }, { w, h }, { 0, h } };
+    addQuad(out, verts, quad.normal, tileUVs, quad.atlasRect);
+}
+
+// Corners of a single block face relative to the block, in the vertex order addMergedQuad
+// gives a 1 x 1 quad, so per-face output needs no plane arithmetic per quad
+struct UnitFace {
+    glm::vec3 corners[4];
+};
+
+const std::array<UnitFace, 6>& unitFaces() {
+    static const std::array<UnitFace, 6> table = [] {
+        std::array<UnitFace, 6> result;
+        for (int face = 0; face < 6; ++face) {
+            const FacePlane& plane = facePlanes[face];
+            auto corner = [&](int cu, int cv) {
+                glm::vec3 p(0.0f);
+                p[plane.normalAxis] = plane.positive ? 1.0f : 0.0f;
+                p[plane.uAxis] = static_cast<float>(cu);
+                p[plane.vAxis] = static_cast<float>(cv);
+                return p;
+            };
+            const int u0 = plane.uSign > 0 ? 0 : 1;
+            const int v0 = plane.vSign > 0 ? 0 : 1;
+            result[face] = { { corner(u0, v0), corner(1 - u0, v0), corner(1 - u0, 1 - v0), corner(u0, 1 - v0) } };
+        }
+        return result;
+    }();
+    return table;
+}
+
+void addUnitQuad(MeshOut& out, const glm::vec3& blockPos, const UnitFace& face, const BakedQuad& quad) {
+    static const glm::vec2 tileUVs[4] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+    const glm::vec3 verts[4] = { blockPos + face.corners[0], blockPos + face.corners[1],
+                                 blockPos + face.corners[2], blockPos + face.corners[3] };
+    addQuad(out, verts, quad.normal, tileUVs, quad.atlasRect);
+}
+
+// Bit s set when slice s of the face direction has two visible faces side by side, the
+// only slices greedy merging can shorten. A row's neighbour in the plane is the next bit
+// (x), the next row along y (r + 1) or along z (r + S); the normal axis is left out.
+uint32_t mergeableSlices(int face, const RowMasks& rows) {
+    const int normalAxis = facePlanes[face].normalAxis;
+    uint32_t slices = 0;
+    for (int r = 0; r < ROWS; ++r) {
+        const int y = r % S;
+        const int z = r / S;
+        uint32_t pairs = 0;
+        if (normalAxis != 0) pairs |= rows[r] & (rows[r] >> 1);
+        if (normalAxis != 1 && y < S - 1) pairs |= rows[r] & rows[r + 1];
+        if (normalAxis != 2 && z < S - 1) pairs |= rows[r] & rows[r + S];
+        if (pairs == 0) continue;
+        switch (normalAxis) {
+            case 0: slices |= pairs; break;
+            case 1: slices |= 1u << y; break;
+            default: slices |= 1u << z; break;
+        }
+    }
+    return slices;
+}
+
+// out[i] = cube[i] & ~(opaque[i] & neighbour[i]): a cube face shows unless both the cube
+// and the block in front of it are opaque
+void cullRows(const uint32_t* cube, const uint32_t* opaque, const uint32_t* neighbour, uint32_t* out) {
+    int i = 0;
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    for (; i + 4 <= ROWS; i += 4) {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cube + i));
+        const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(opaque + i));
+        const __m128i n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(neighbour + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_andnot_si128(_mm_and_si128(o, n), c));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= ROWS; i += 4) {
+        vst1q_u32(out + i, vbicq_u32(vld1q_u32(cube + i), vandq_u32(vld1q_u32(opaque + i), vld1q_u32(neighbour + i))));
+    }
+#endif
+    for (; i < ROWS; ++i) {
+        out[i] = cube[i] & ~(opaque[i] & neighbour[i]);
+    }
+}
+
+// Visible faces of all full cubes, per face one mask per (y, z) row with bit x set. The
+// opacity in front of each row is the row itself shifted along x, the next row along y
+// or z, or the neighbour's border layer at the chunk edge.
+void cullCubeFaces(const ChunkMeshSource& source, const RowMasks& cubeRows, std::array<RowMasks, 6>& visible) {
+    static const RowMasks noOpacity{};
+    const uint32_t* opaque = source.opacity->getRows() ? source.opacity->getRows() : noOpacity.data();
+    const auto& borders = source.borders;
+
+    RowMasks neighbour;
+    for (int face = 0; face < 6; ++face) {
+        for (int z = 0; z < S; ++z) {
+            for (int y = 0; y < S; ++y) {
+                const int r = y + S * z;
+                switch (face) {
+                    case 0: neighbour[r] = (opaque[r] >> 1) | (((borders[0][z] >> y) & 1u) << (S - 1)); break;
+                    case 1: neighbour[r] = (opaque[r] << 1) | ((borders[1][z] >> y) & 1u); break;
+                    case 2: neighbour[r] = y < S - 1 ? opaque[r + 1] : borders[2][z]; break;
+                    case 3: neighbour[r] = y > 0 ? opaque[r - 1] : borders[3][z]; break;
+                    case 4: neighbour[r] = z < S - 1 ? opaque[r + S] : borders[4][y]; break;
+                    default: neighbour[r] = z > 0 ? opaque[r - S] : borders[5][y]; break;
+                }
+            }
+        }
+        cullRows(cubeRows.data(), opaque, neighbour.data(), visible[face].data());
+    }
+}
+
+// Calls fn(x, y, z) for every set bit of the row masks
+template<typename Fn>
+void forEachBit(const RowMasks& rows, Fn&& fn) {
+    for (int r = 0; r < ROWS; ++r) {
+        for (uint32_t bits = rows[r]; bits != 0; bits &= bits - 1) {
+            fn(std::countr_zero(bits), r % S, r / S);
+        }
+    }
+}
+
+// Covers the marked cells of rows vFirst..vLast of one slice with as few rectangles of
+// one texture as the greedy scan finds, and leaves the slice unmarked again
+void mergeSlice(MeshOut& out, const glm::ivec3& chunkOrigin, int face, int slice, int vFirst, int vLast,
+                const BakedQuad** mask) {
+    auto sameTexture = [](const BakedQuad* a, const BakedQuad* b) { return a && a->texture == b->texture; };
+    for (int v = vFirst; v <= vLast; ++v) {
+        for (int u = 0; u < S;) {
+            const BakedQuad* quad = mask[v * S + u];
+            if (!quad) {
+                ++u;
+                continue;
+            }
+
+            int w = 1;
+            while (u + w < S && sameTexture(mask[v * S + u + w], quad)) ++w;
+            int h = 1;
+            for (; v + h <= vLast; ++h) {
+                const auto* row = &mask[(v + h) * S + u];
+                if (!std::all_of(row, row + w, [&](const BakedQuad* q) { return sameTexture(q, quad); })) break;
+            }
+
+            for (int dv = 0; dv < h; ++dv) {
+                std::fill_n(&mask[(v + dv) * S + u], w, nullptr);
+            }
+            addMergedQuad(out, chunkOrigin, face, slice, u, v, w, h, *quad);
+            u += w;
+        }
+    }
+}
+
+void emitCubeFaces(MeshOut& out, const ChunkMeshSource& source, MeshingMode mode, const std::vector<uint16_t>& paletteIndices,
+                   const std::vector<const BakedBlockModel*>& models, const std::array<RowMasks, 6>& visible) {
+    const glm::ivec3 chunkOrigin = source.chunkPos * S;
+
+    size_t count = 0;
+    for (const auto& rows : visible) {
+        for (uint32_t bits : rows) count += std::popcount(bits);
+    }
+    out.vertices.reserve(out.vertices.size() + count * 4);
+    out.indices.reserve(out.indices.size() + count * 6);
+
+    const BlockCache& cache = BlockCache::getInstance();
+    auto quadAt = [&](int x, int y, int z, int face) {
+        return &cache.getBakedQuads(*models[paletteIndices[ChunkBlockStorage::toIndex(x, y, z)]], face)[0];
+    };
+
+    const glm::vec3 origin(chunkOrigin);
+    const auto& units = unitFaces();
+    if (mode == MeshingMode::Faces) {
+        for (int face = 0; face < 6; ++face) {
+            forEachBit(visible[face], [&](int x, int y, int z) {
+                addUnitQuad(out, origin + glm::vec3(x, y, z), units[face], *quadAt(x, y, z, face));
+            });
+        }
+        return;
+    }
+
+    // One mask per slice for a whole face direction; mergeSlice leaves it empty, so it is
+    // cleared once per thread and never again
+    thread_local std::vector<const BakedQuad*> mask(ChunkBlockStorage::VOLUME, nullptr);
+    for (int face = 0; face < 6; ++face) {
+        const FacePlane& plane = facePlanes[face];
+        // Slices without touching faces have nothing to merge and are emitted face by face
+        const uint32_t mergeable = mergeableSlices(face, visible[face]);
+        // Marked rows per slice, first > last while the slice is empty
+        std::array<int, S> vFirst;
+        std::array<int, S> vLast;
+        vFirst.fill(S);
+        vLast.fill(-1);
+        forEachBit(visible[face], [&](int x, int y, int z) {
+            const glm::ivec3 p(x, y, z);
+            const int slice = p[plane.normalAxis];
+            if (!((mergeable >> slice) & 1u)) {
+                addUnitQuad(out, origin + glm::vec3(p), units[face], *quadAt(x, y, z, face));
+                return;
+            }
+            const int v = p[plane.vAxis];
+            mask[slice * S * S + v * S + p[plane.uAxis]] = quadAt(x, y, z, face);
+            vFirst[slice] = std::min(vFirst[slice], v);
+            vLast[slice] = std::max(vLast[slice], v);
+        });
+        for (int slice = 0; slice < S; ++slice) {
+            if (vFirst[slice] <= vLast[slice]) {
+                mergeSlice(out, chunkOrigin, face, slice, vFirst[slice], vLast[slice], &mask[slice * S * S]);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void ChunkMesher::build(const ChunkMeshSource& source, MeshingMode mode,
+                        std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    MeshOut out{ vertices, indices };
+    const BlockCache& cache = BlockCache::getInstance();
+    const ChunkBlockStorage& blocks = *source.blocks;
+    const auto& palette = blocks.getPalette();
+
+    std::vector<const BakedBlockModel*> paletteModels(palette.size());
+    bool anyCube = false;
+    bool anyOther = false;
+    for (size_t i = 0; i < palette.size(); ++i) {
+        paletteModels[i] = &cache.getBakedModel(palette[i]);
+        anyCube |= paletteModels[i]->isCube;
+        anyOther |= !paletteModels[i]->isCube && !paletteModels[i]->isEmpty;
+    }
+
+    std::vector<uint16_t> paletteIndices(ChunkBlockStorage::VOLUME);
+    RowMasks cubeRows{};
+    for (int r = 0; r < ROWS; ++r) {
+        uint32_t row = 0;
+        for (int x = 0; x < S; ++x) {
+            const int index = r * S + x;
+            paletteIndices[index] = blocks.getPaletteIndex(index);
+            row |= (paletteModels[paletteIndices[index]]->isCube ? 1u : 0u) << x;
+        }
+        cubeRows[r] = row;
+    }
+
+    // Full cubes go through the bitmask kernel, the per-block walk below takes what is left
+    if (anyCube) {
+        std::array<RowMasks, 6> visible;
+        cullCubeFaces(source, cubeRows, visible);
+        emitCubeFaces(out, source, mode, paletteIndices, paletteModels, visible);
+    }
+    if (!anyOther) return;
+
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < S; ++y)
+        for (int x = 0; x < S; ++x) {
+            glm::ivec3 localPos(x, y, z);
+
+            const BakedBlockModel& model = *paletteModels[paletteIndices[ChunkBlockStorage::toIndex(x, y, z)]];
+            if (model.isEmpty || model.isCube) continue;
+
+            glm::ivec3 baseWorldPos = source.chunkPos * S + localPos;
+
+            for (int i = 0; i < 6; ++i) {
+                if (model.count[i] == 0) continue;
+                const bool hidden = isOpaque(source, localPos + faces[i].neighborOffset);
+                for (const BakedQuad& quad : cache.getBakedQuads(model, i)) {
+                    if (quad.cull && hidden) continue;
+                    addBakedQuad(out, baseWorldPos, quad);
+                }
+            }
+        }
+}
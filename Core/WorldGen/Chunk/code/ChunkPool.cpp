@@ -0,0 +1,62 @@
+#include "ChunkPool.h"
+#include "Chunk.h"
+
+ChunkPool::ChunkPool() {
+    _free.reserve(_maxPooled);
+}
+
+std::unique_ptr<Chunk> ChunkPool::acquire(const ChunkPos& pos) {
+    std::unique_ptr<Chunk> chunk;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.acquired;
+        ++_stats.inUse;
+        _stats.highWater = std::max(_stats.highWater, _stats.inUse);
+
+        if (!_free.empty()) {
+            chunk = std::move(_free.back());
+            _free.pop_back();
+            ++_stats.recycled;
+        } else {
+            ++_stats.allocated;
+        }
+        _stats.pooled = _free.size();
+    }
+
+    if (chunk) {
+        chunk->reset(pos);
+        return chunk;
+    }
+    return std::make_unique<Chunk>(pos);
+}
+
+void ChunkPool::release(std::unique_ptr<Chunk> chunk) {
+    if (!chunk) return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stats.inUse > 0) --_stats.inUse;
+
+        if (_free.size() < _maxPooled) {
+            _free.push_back(std::move(chunk));
+        }
+        _stats.pooled = _free.size();
+    }
+    // Over the cap the chunk is destroyed here, outside the lock
+}
+
+ChunkPoolStats ChunkPool::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void ChunkPool::setMaxPooled(size_t maxPooled) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxPooled = maxPooled;
+    if (_free.size() > _maxPooled) {
+        _free.resize(_maxPooled);
+    }
+    _free.reserve(_maxPooled);
+    _stats.pooled = _free.size();
+}
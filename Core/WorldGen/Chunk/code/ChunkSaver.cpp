@@ -0,0 +1,169 @@
+#include "ChunkSaver.h"
+#include "ChunkDataAccess.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+ChunkSaver::ChunkSaver() {
+    _thread = std::thread(&ChunkSaver::run, this);
+}
+
+ChunkSaver::~ChunkSaver() {
+    shutdown();
+}
+
+void ChunkSaver::schedule(ChunkSnapshot snapshot, const std::string& worldName) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.scheduled;
+
+        if (!_stopped) {
+            const bool wasEmpty = _pending.empty();
+            if (wasEmpty) {
+                _oldestPending = std::chrono::steady_clock::now();
+            }
+            ChunkPos pos = snapshot.pos;
+            auto [it, inserted] = _pending.try_emplace(pos, PendingSave{ std::move(snapshot), worldName });
+            if (!inserted) {
+                it->second = PendingSave{ std::move(snapshot), worldName };
+                ++_stats.coalesced;
+            }
+            _stats.pending = _pending.size() + _inFlight.size();
+            if (wasEmpty || _pending.size() >= MAX_PENDING) {
+                _wake.notify_one();
+            }
+            return;
+        }
+    }
+
+    // Writer already stopped (application exit), nothing else would persist it
+    if (!write(PendingSave{ std::move(snapshot), worldName })) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_stats.failed;
+        ++_stats.lost;
+    }
+}
+
+std::optional<ChunkSnapshot> ChunkSaver::findPending(const ChunkPos& pos) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (auto it = _pending.find(pos); it != _pending.end()) return it->second.snapshot;
+    if (auto it = _inFlight.find(pos); it != _inFlight.end()) return it->second.snapshot;
+    return std::nullopt;
+}
+
+bool ChunkSaver::hasPending(const ChunkPos& pos) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pending.contains(pos) || _inFlight.contains(pos);
+}
+
+size_t ChunkSaver::flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_stopped || (_pending.empty() && _inFlight.empty())) return 0;
+
+    // The batch in flight may have been taken before the latest schedule() calls
+    const uint64_t target = _batches + (_inFlight.empty() ? 0 : 1) + (_pending.empty() ? 0 : 1);
+    if (!_pending.empty()) {
+        _flushRequested = true;
+        _wake.notify_one();
+    }
+    _drained.wait(lock, [this, target] { return _stopped || _batches >= target; });
+    return _requeued;
+}
+
+std::vector<ChunkSnapshot> ChunkSaver::takePending(const std::string& worldName) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _drained.wait(lock, [this] { return _inFlight.empty(); });
+
+    std::vector<ChunkSnapshot> snapshots;
+    for (auto it = _pending.begin(); it != _pending.end();) {
+        if (it->second.worldName != worldName) {
+            ++it;
+            continue;
+        }
+        snapshots.push_back(std::move(it->second.snapshot));
+        it = _pending.erase(it);
+    }
+    _requeued = std::min(_requeued, _pending.size());
+    _stats.pending = _pending.size();
+    return snapshots;
+}
+
+size_t ChunkSaver::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stopping) return _stats.lost;
+        _stopping = true;
+    }
+    _wake.notify_one();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats.lost;
+}
+
+ChunkSaverStats ChunkSaver::getStats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+void ChunkSaver::run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    while (true) {
+        _wake.wait(lock, [this] { return _stopping || !_pending.empty(); });
+
+        // Give edits FLUSH_INTERVAL to coalesce unless the queue is full or a flush was asked for
+        _wake.wait_until(lock, _oldestPending + FLUSH_INTERVAL, [this] {
+            return _stopping || _flushRequested || _pending.size() >= MAX_PENDING + _requeued;
+        });
+
+        _inFlight.swap(_pending);
+        _flushRequested = false;
+
+        lock.unlock();
+        size_t written = 0;
+        std::vector<ChunkPos> failed;
+        for (const auto& [pos, save] : _inFlight) {
+            if (write(save)) ++written; else failed.push_back(pos);
+        }
+        lock.lock();
+
+        // Queued again for the next batch; a snapshot scheduled meanwhile is newer and wins
+        _requeued = 0;
+        if (!_stopping) {
+            for (const auto& pos : failed) {
+                auto node = _inFlight.extract(pos);
+                if (_pending.try_emplace(pos, std::move(node.mapped())).second) ++_requeued;
+            }
+        } else if (!failed.empty()) {
+            _stats.lost += failed.size();
+            Logger::getInstance().Log("Shutdown: " + std::to_string(failed.size()) + " chunks could not be saved",
+                LogLevel::Error);
+        }
+
+        _inFlight.clear();
+        ++_batches;
+        _stats.written += written;
+        _stats.failed += failed.size();
+        _stats.pending = _pending.size();
+        if (!_pending.empty()) {
+            _oldestPending = std::chrono::steady_clock::now();
+        }
+        _drained.notify_all();
+
+        if (_stopping && _pending.empty()) {
+            _stopped = true;
+            return;
+        }
+    }
+}
+
+bool ChunkSaver::write(const PendingSave& save) {
+    ChunkDataAccess dataAccess;
+    if (dataAccess.saveChunkToDisk(save.snapshot, save.worldName)) {
+        return true;
+    }
+    Logger::getInstance().Log("Failed to save chunk " + save.snapshot.pos.toString(), LogLevel::Error);
+    return false;
+}
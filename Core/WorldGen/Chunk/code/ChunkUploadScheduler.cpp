@@ -0,0 +1,228 @@
+#include "ChunkUploadScheduler.h"
+#include "ChunkController.h"
+#include "Camera.h"
+#include "Logger.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace {
+
+// Not in the GL 3.3 loader
+typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+bool hasBufferStorage() {
+    GLint major = 0;
+    GLint minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 4)) return true;
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name && std::strcmp(name, "GL_ARB_buffer_storage") == 0) return true;
+    }
+    return false;
+}
+
+size_t alignUp(size_t bytes) {
+    return (bytes + 15) & ~size_t(15);
+}
+
+} // namespace
+
+bool StagingRing::create(size_t bytes) {
+    auto bufferStorage = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+    if (!hasBufferStorage() || !bufferStorage) return false;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr total = static_cast<GLsizeiptr>(bytes * SEGMENTS);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    bufferStorage(GL_COPY_READ_BUFFER, total, nullptr, flags);
+    mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, total, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!mapped) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        return false;
+    }
+    segmentBytes = bytes;
+    return true;
+}
+
+void StagingRing::destroy() {
+    for (auto& fence : fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (mapped) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        mapped = nullptr;
+    }
+    if (buffer) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    open = false;
+}
+
+bool StagingRing::beginFrame(std::chrono::nanoseconds maxWait) {
+    GLsync& fence = fences[segment];
+    if (fence) {
+        const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, static_cast<GLuint64>(maxWait.count()));
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) return false;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+    used = 0;
+    open = true;
+    return true;
+}
+
+bool StagingRing::stage(const void* first, size_t firstBytes, const void* second, size_t secondBytes,
+                        GLintptr& firstOffset, GLintptr& secondOffset) {
+    if (!open || used + alignUp(firstBytes) + alignUp(secondBytes) > segmentBytes) return false;
+
+    const size_t base = static_cast<size_t>(segment) * segmentBytes;
+    firstOffset = static_cast<GLintptr>(base + used);
+    if (firstBytes > 0) std::memcpy(mapped + base + used, first, firstBytes);
+    used += alignUp(firstBytes);
+
+    secondOffset = static_cast<GLintptr>(base + used);
+    if (secondBytes > 0) std::memcpy(mapped + base + used, second, secondBytes);
+    used += alignUp(secondBytes);
+    return true;
+}
+
+void StagingRing::endFrame() {
+    if (!open) return;
+    open = false;
+    if (used == 0) return;
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    segment = (segment + 1) % SEGMENTS;
+}
+
+void ChunkUploadScheduler::enqueue(const ChunkPos& pos, bool urgent) {
+    bool& queuedUrgent = _queued[pos];
+    queuedUrgent = queuedUrgent || urgent;
+}
+
+void ChunkUploadScheduler::process(ChunkController& controller, const Camera* camera) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+
+    if (!_ringTried) {
+        _ringTried = true;
+        if (_ring.create(FRAME_BYTE_BUDGET)) {
+            Logger::getInstance().Log("Chunk uploads: staging ring of " +
+                std::to_string(FRAME_BYTE_BUDGET * StagingRing::SEGMENTS / (1024 * 1024)) + " MB");
+        } else {
+            Logger::getInstance().Log("Chunk uploads: no persistent mapping, uploading directly", LogLevel::Warning);
+        }
+    }
+
+    struct Candidate {
+        ChunkPos pos;
+        Chunk* chunk;
+        bool urgent;
+        bool visible;
+        int distance;
+        size_t bytes;
+    };
+
+    // In view: the chunk's center within a cone around the view direction wide enough for any
+    // aspect ratio, or the chunk is close enough to be partly in view from any direction
+    const float coneCos = camera ? std::cos(glm::radians(std::min(camera->FOV, 89.0f))) : -1.0f;
+    const glm::vec3 eye = camera ? camera->Position : glm::vec3(0.0f);
+    const glm::ivec3 center = controller.toChunkPos(glm::ivec3(glm::floor(eye))).position;
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(_queued.size());
+    for (auto it = _queued.begin(); it != _queued.end();) {
+        auto chunkOpt = controller.findChunk(it->first);
+        if (!chunkOpt || chunkOpt->get().getMesh().isUploaded) {
+            it = _queued.erase(it);
+            continue;
+        }
+
+        Chunk& chunk = chunkOpt->get();
+        const glm::ivec3 offset = glm::abs(it->first.position - center);
+        const glm::vec3 toChunk = (glm::vec3(it->first.position) + 0.5f) * static_cast<float>(Chunk::CHUNK_SIZE) - eye;
+        const float length = glm::length(toChunk);
+        const bool visible = !camera || length < Chunk::CHUNK_SIZE * 1.8f ||
+                             glm::dot(toChunk / length, camera->Front) >= coneCos;
+        candidates.push_back(Candidate{ it->first, &chunk, it->second, visible,
+                                        std::max({ offset.x, offset.y, offset.z }),
+                                        chunk.getMesh().getVertexBytes() + chunk.getMesh().getIndexBytes() });
+        ++it;
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.urgent != b.urgent) return a.urgent;
+        if (a.visible != b.visible) return a.visible;
+        return a.distance < b.distance;
+    });
+
+    ChunkUploadStats frame;
+    frame.stagingRing = _ring.isReady();
+    _budget.beginFrame(start);
+
+    bool staging = false;
+    if (!candidates.empty() && _ring.isReady()) {
+        const auto waitStart = Clock::now();
+        staging = _ring.beginFrame(FRAME_TIME_BUDGET / 4);
+        frame.stallMs = std::chrono::duration<double, std::milli>(Clock::now() - waitStart).count();
+    }
+
+    for (const auto& candidate : candidates) {
+        if (!_budget.admits(candidate.bytes, candidate.urgent, Clock::now())) break;
+
+        ChunkMesh& mesh = candidate.chunk->getMesh();
+        const auto uploadStart = Clock::now();
+        GLintptr vertexOffset = 0;
+        GLintptr indexOffset = 0;
+        if (staging && _ring.stage(mesh.meshBuilder.vertices.data(), mesh.getVertexBytes(),
+                                   mesh.meshBuilder.indices.data(), mesh.getIndexBytes(), vertexOffset, indexOffset)) {
+            mesh.uploadFromStaging(_ring.getBuffer(), vertexOffset, indexOffset);
+        } else if (staging && !candidate.urgent && candidate.bytes <= _ring.getSegmentBytes()) {
+            // Segment full, the rest waits for the next one
+            break;
+        } else {
+            mesh.uploadToGPU();
+        }
+
+        _budget.record(candidate.bytes, std::chrono::duration<double, std::nano>(Clock::now() - uploadStart).count());
+        _queued.erase(candidate.pos);
+    }
+
+    if (staging) _ring.endFrame();
+
+    frame.uploads = _budget.getUploads();
+    frame.bytes = _budget.getBytes();
+    frame.queued = _queued.size();
+    frame.uploadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    _lastFrame = frame;
+}
+
+void ChunkUploadScheduler::shutdown() {
+    _ring.destroy();
+    _queued.clear();
+}
+
+ChunkUploadStats ChunkUploadScheduler::getStats() const {
+    return _lastFrame;
+}
@@ -0,0 +1,310 @@
+#include "RegionFile.h"
+
+#include <mutex>
+
+RegionFile::RegionFile(const fs::path& path) : _path(path) {
+    std::error_code ec;
+    if (!fs::exists(_path, ec)) {
+        std::ofstream create(_path, std::ios::binary | std::ios::trunc);
+        if (!create.is_open()) return;
+        const std::vector<char> header(HEADER_SECTORS * SECTOR_SIZE, 0);
+        create.write(header.data(), static_cast<std::streamsize>(header.size()));
+        if (!create.good()) return;
+    }
+
+    _file.open(_path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!_file.is_open()) return;
+
+    const uint64_t fileSize = fs::file_size(_path, ec);
+    if (ec || fileSize < HEADER_SECTORS * SECTOR_SIZE) {
+        _file.close();
+        return;
+    }
+
+    _file.seekg(0);
+    _file.read(reinterpret_cast<char*>(_header.data()), static_cast<std::streamsize>(sizeof(_header)));
+    if (!_file.good()) {
+        _file.close();
+        return;
+    }
+
+    const uint32_t fileSectors = static_cast<uint32_t>(fileSize / SECTOR_SIZE);
+    _usedSectors.assign(fileSectors, false);
+    markSectors(0, HEADER_SECTORS, true);
+
+    // Entries pointing outside the file or into the header are dropped, the chunk regenerates
+    for (auto& entry : _header) {
+        if (entry.sector == 0) continue;
+        if (!isValidEntry(entry, fileSectors)) {
+            entry = Entry{};
+            continue;
+        }
+        if (entry.sector != INLINE_SECTOR) {
+            if (_usedSectors[entry.sector]) ++_sectorRefs.try_emplace(entry.sector, 1).first->second;
+            markSectors(entry.sector, sectorsFor(entry.length), true);
+        }
+        ++_chunkCount;
+    }
+
+    if (fileSize % SECTOR_SIZE != 0) {
+        growTo(fileSectors + 1);
+    }
+    _mapped.map(_path);
+
+#ifdef _WIN32
+    _syncHandle = CreateFileW(_path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+    _syncFd = ::open(_path.c_str(), O_WRONLY);
+#endif
+}
+
+RegionFile::~RegionFile() {
+#ifdef _WIN32
+    if (_syncHandle != INVALID_HANDLE_VALUE) CloseHandle(_syncHandle);
+#else
+    if (_syncFd >= 0) ::close(_syncFd);
+#endif
+}
+
+bool RegionFile::isValidEntry(const Entry& entry, uint32_t fileSectors) {
+    if (entry.sector == INLINE_SECTOR) {
+        const uint32_t size = entry.length >> 24;
+        return size != 0 && size <= MAX_INLINE;
+    }
+    return entry.sector >= HEADER_SECTORS && entry.length != 0
+        && static_cast<uint64_t>(entry.sector) + sectorsFor(entry.length) <= fileSectors;
+}
+
+bool RegionFile::readPresence(const fs::path& path, PresenceMask& mask) {
+    mask.fill(0);
+
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(path, ec);
+    if (ec || fileSize < HEADER_SECTORS * SECTOR_SIZE) return false;
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<Entry> header(CHUNK_COUNT);
+    file.read(reinterpret_cast<char*>(header.data()), static_cast<std::streamsize>(header.size() * sizeof(Entry)));
+    if (!file.good()) return false;
+
+    const uint32_t fileSectors = static_cast<uint32_t>(fileSize / SECTOR_SIZE);
+    for (int i = 0; i < CHUNK_COUNT; ++i) {
+        if (header[i].sector != 0 && isValidEntry(header[i], fileSectors)) {
+            mask[i >> 6] |= uint64_t(1) << (i & 63);
+        }
+    }
+    return true;
+}
+
+bool RegionFile::write(const ChunkPos& pos, const char* data, size_t size, bool durable) {
+    std::unique_lock lock(_mutex);
+    if (!_file.is_open() || size == 0 || size > UINT32_MAX) return false;
+
+    const int index = toLocalIndex(pos);
+    const Entry previous = _header[index];
+
+    if (size <= MAX_INLINE) {
+        uint32_t packed = static_cast<uint32_t>(size) << 24;
+        for (size_t i = 0; i < size; ++i) {
+            packed |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+        }
+        _header[index] = Entry{ INLINE_SECTOR, packed };
+        if (!writeHeaderEntry(index)) {
+            _header[index] = previous;
+            return false;
+        }
+        releaseEntry(previous);
+        return !durable || syncData();
+    }
+
+    if (size <= SECTOR_SIZE) {
+        const uint32_t shared = findSharedPayload(data, size);
+        if (shared != 0) {
+            if (previous.sector == shared) return true;
+            _header[index] = Entry{ shared, static_cast<uint32_t>(size) };
+            if (!writeHeaderEntry(index)) {
+                _header[index] = previous;
+                return false;
+            }
+            ++_sectorRefs.try_emplace(shared, 1).first->second;
+            releaseEntry(previous);
+            return !durable || syncData();
+        }
+    }
+
+    const uint32_t count = sectorsFor(size);
+    const uint32_t first = allocate(count);
+    if (first == 0) return false;
+
+    _file.seekp(static_cast<std::streamoff>(first) * SECTOR_SIZE);
+    _file.write(data, static_cast<std::streamsize>(size));
+    _file.flush();
+    if (!_file.good() || (durable && !syncData())) {
+        _file.clear();
+        markSectors(first, count, false);
+        return false;
+    }
+
+    _header[index] = Entry{ first, static_cast<uint32_t>(size) };
+    if (!writeHeaderEntry(index)) {
+        _header[index] = previous;
+        markSectors(first, count, false);
+        return false;
+    }
+    if (count == 1 && _payloadIndexBuilt) {
+        _payloadIndex[std::hash<std::string_view>{}(std::string_view(data, size))] = first;
+    }
+    releaseEntry(previous);
+    // The entry is written either way; false only tells a checkpoint it is not known to be on disk
+    return !durable || syncData();
+}
+
+bool RegionFile::erase(const ChunkPos& pos, bool durable) {
+    std::unique_lock lock(_mutex);
+    const int index = toLocalIndex(pos);
+    const Entry previous = _header[index];
+    if (previous.sector == 0) return false;
+
+    _header[index] = Entry{};
+    if (!writeHeaderEntry(index)) {
+        _header[index] = previous;
+        return false;
+    }
+    releaseEntry(previous);
+    --_chunkCount;
+    return !durable || syncData();
+}
+
+RegionFileStats RegionFile::getStats() const {
+    std::shared_lock lock(_mutex);
+    RegionFileStats stats;
+    stats.chunks = _chunkCount;
+    stats.fileSectors = _usedSectors.size();
+    for (size_t sector = 0; sector < _usedSectors.size(); ++sector) {
+        if (!_usedSectors[sector]) continue;
+        ++stats.usedSectors;
+        stats.usedEnd = sector + 1;
+    }
+    for (const auto& [sector, refs] : _sectorRefs) {
+        stats.sharedChunks += refs - 1;
+    }
+    return stats;
+}
+
+uint32_t RegionFile::allocate(uint32_t count) {
+    const uint32_t total = static_cast<uint32_t>(_usedSectors.size());
+
+    uint32_t runStart = HEADER_SECTORS;
+    uint32_t runLength = 0;
+    for (uint32_t sector = HEADER_SECTORS; sector < total; ++sector) {
+        if (_usedSectors[sector]) {
+            runStart = sector + 1;
+            runLength = 0;
+            continue;
+        }
+        if (++runLength == count) {
+            markSectors(runStart, count, true);
+            return runStart;
+        }
+    }
+
+    // Nothing fits: extend the trailing free run (runStart..total) at the end of the file
+    if (!growTo(runStart + count + GROWTH_SECTORS)) return 0;
+    markSectors(runStart, count, true);
+    return runStart;
+}
+
+void RegionFile::markSectors(uint32_t first, uint32_t count, bool used) {
+    for (uint32_t sector = first; sector < first + count && sector < _usedSectors.size(); ++sector) {
+        _usedSectors[sector] = used;
+    }
+}
+
+// Frees what a replaced entry occupied; a previously empty slot means one more chunk
+void RegionFile::releaseEntry(const Entry& entry) {
+    if (entry.sector == 0) {
+        ++_chunkCount;
+        return;
+    }
+    if (entry.sector == INLINE_SECTOR) return;
+
+    auto shared = _sectorRefs.find(entry.sector);
+    if (shared != _sectorRefs.end()) {
+        if (--shared->second == 1) _sectorRefs.erase(shared);
+        return;
+    }
+
+    if (_payloadIndexBuilt && entry.length <= SECTOR_SIZE) {
+        auto indexed = _payloadIndex.find(std::hash<std::string_view>{}(mappedPayload(entry)));
+        if (indexed != _payloadIndex.end() && indexed->second == entry.sector) _payloadIndex.erase(indexed);
+    }
+    markSectors(entry.sector, sectorsFor(entry.length), false);
+}
+
+uint32_t RegionFile::findSharedPayload(const char* data, size_t size) {
+    if (!_payloadIndexBuilt) buildPayloadIndex();
+
+    const std::string_view payload(data, size);
+    auto it = _payloadIndex.find(std::hash<std::string_view>{}(payload));
+    if (it == _payloadIndex.end()) return 0;
+
+    // A hash match is only a candidate: compare the bytes and the stored length
+    for (const Entry& entry : _header) {
+        if (entry.sector != it->second) continue;
+        return entry.length == size && mappedPayload(entry) == payload ? entry.sector : 0;
+    }
+    return 0;
+}
+
+// Reads every single-sector payload once, the first time this region is written to
+void RegionFile::buildPayloadIndex() {
+    _payloadIndexBuilt = true;
+    for (const Entry& entry : _header) {
+        if (entry.sector == 0 || entry.sector == INLINE_SECTOR || entry.length > SECTOR_SIZE) continue;
+        _payloadIndex.try_emplace(std::hash<std::string_view>{}(mappedPayload(entry)), entry.sector);
+    }
+}
+
+std::string_view RegionFile::mappedPayload(const Entry& entry) const {
+    const size_t begin = static_cast<size_t>(entry.sector) * SECTOR_SIZE;
+    if (begin + entry.length > _mapped.size()) return {};
+    return std::string_view(_mapped.data() + begin, entry.length);
+}
+
+bool RegionFile::growTo(uint32_t sectors) {
+    if (sectors <= _usedSectors.size()) return true;
+
+    const char zero = 0;
+    _file.seekp(static_cast<std::streamoff>(sectors) * SECTOR_SIZE - 1);
+    _file.write(&zero, 1);
+    _file.flush();
+    if (!_file.good()) {
+        _file.clear();
+        return false;
+    }
+
+    _usedSectors.resize(sectors, false);
+    return _mapped.map(_path);
+}
+
+bool RegionFile::writeHeaderEntry(int index) {
+    _file.seekp(static_cast<std::streamoff>(index) * sizeof(Entry));
+    _file.write(reinterpret_cast<const char*>(&_header[index]), sizeof(Entry));
+    _file.flush();
+    if (!_file.good()) {
+        _file.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RegionFile::syncData() {
+#ifdef _WIN32
+    return _syncHandle != INVALID_HANDLE_VALUE && FlushFileBuffers(_syncHandle);
+#elif defined(__APPLE__)
+    return _syncFd >= 0 && ::fsync(_syncFd) == 0;
+#else
+    return _syncFd >= 0 && ::fdatasync(_syncFd) == 0;
+#endif
+}
@@ -0,0 +1,172 @@
+#include "RegionStorage.h"
+#include "PathProvider.h"
+#include "Logger.h"
+#include "AsyncFileIO.h"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+std::shared_ptr<RegionFile> RegionStorage::getRegion(const std::string& worldName, const ChunkPos& pos, bool create) {
+    RegionKey key{ worldName, RegionFile::toRegionPos(pos) };
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _open.find(key);
+    if (it != _open.end()) {
+        _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+        return it->second.file;
+    }
+
+    if (!create && _missing.contains(key)) return nullptr;
+
+    fs::path path = PathProvider::getInstance().getRegionFilePath(worldName, key.regionPos);
+    std::error_code ec;
+    if (!create && !fs::exists(path, ec)) {
+        _missing.insert(key);
+        return nullptr;
+    }
+    if (create) {
+        fs::create_directories(path.parent_path(), ec);
+    }
+
+    auto file = std::make_shared<RegionFile>(path);
+    if (!file->isOpen()) {
+        Logger::getInstance().Log("Failed to open region file: " + path.string(), LogLevel::Error);
+        return nullptr;
+    }
+    _missing.erase(key);
+
+    // Only regions nobody holds are closed: a second RegionFile on the same path would
+    // keep its own sector map and hand out sectors the first one still uses. Handles
+    // are only given out under _mutex, so a count of 1 here cannot grow.
+    if (_open.size() >= MAX_OPEN_REGIONS) {
+        for (auto lruIt = std::prev(_lru.end()); ; --lruIt) {
+            auto openIt = _open.find(*lruIt);
+            if (openIt->second.file.use_count() == 1) {
+                _open.erase(openIt);
+                _lru.erase(lruIt);
+                break;
+            }
+            if (lruIt == _lru.begin()) break;
+        }
+    }
+    _lru.push_front(key);
+    _open.emplace(std::move(key), OpenRegion{ file, _lru.begin() });
+    return file;
+}
+
+ChunkIndex& RegionStorage::getIndex(const std::string& worldName) {
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    auto& index = _indices[worldName];
+    if (!index) {
+        index = std::make_unique<ChunkIndex>(worldName);
+    }
+    return *index;
+}
+
+bool RegionStorage::releaseRegion(const RegionKey& key, const fs::path& path) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _open.find(key);
+        if (it != _open.end()) {
+            if (it->second.file.use_count() > 1) return false;
+            _lru.erase(it->second.lruIt);
+            _open.erase(it);
+        }
+        _missing.erase(key);
+    }
+    AsyncFileIO::getInstance().invalidate(path);
+    return true;
+}
+
+bool RegionStorage::replaceRegion(const std::string& worldName, const glm::ivec3& regionPos, const fs::path& replacement) {
+    fs::path path = PathProvider::getInstance().getRegionFilePath(worldName, regionPos);
+    if (!releaseRegion(RegionKey{ worldName, regionPos }, path)) return false;
+
+    std::error_code ec;
+    fs::rename(replacement, path, ec);
+    if (ec) {
+        Logger::getInstance().Log("Failed to replace region file " + path.string() + ": " + ec.message(), LogLevel::Error);
+        return false;
+    }
+
+    RegionFile::PresenceMask mask{};
+    RegionFile::readPresence(path, mask);
+    getIndex(worldName).setRegion(regionPos, mask);
+    return true;
+}
+
+bool RegionStorage::removeRegion(const std::string& worldName, const glm::ivec3& regionPos) {
+    fs::path path = PathProvider::getInstance().getRegionFilePath(worldName, regionPos);
+    if (!releaseRegion(RegionKey{ worldName, regionPos }, path)) return false;
+
+    std::error_code ec;
+    fs::remove(path, ec);
+    if (ec) return false;
+    getIndex(worldName).setRegion(regionPos, RegionFile::PresenceMask{});
+    return true;
+}
+
+size_t RegionStorage::convertLegacyChunks(const std::string& worldName) {
+    fs::path legacyPath = PathProvider::getInstance().getWorldChunksPath(worldName);
+    std::error_code ec;
+    if (!fs::is_directory(legacyPath, ec)) return 0;
+
+    size_t converted = 0;
+    size_t failed = 0;
+    std::vector<fs::path> done;
+
+    for (const auto& entry : fs::directory_iterator(legacyPath, ec)) {
+        if (!entry.is_regular_file()) continue;
+
+        // Chunk_x_y_z, see ChunkPos::toString
+        std::string name = entry.path().filename().string();
+        if (name.rfind("Chunk_", 0) != 0) continue;
+        std::istringstream iss(name.substr(6));
+        int x, y, z;
+        char sep1, sep2;
+        if (!(iss >> x >> sep1 >> y >> sep2 >> z) || sep1 != '_' || sep2 != '_' || !iss.eof()) continue;
+
+        std::ifstream ifs(entry.path(), std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        if (bytes.empty() || !write(worldName, ChunkPos(x, y, z), bytes)) {
+            ++failed;
+            continue;
+        }
+        done.push_back(entry.path());
+        ++converted;
+    }
+
+    for (const auto& path : done) {
+        fs::remove(path, ec);
+    }
+    if (failed == 0) {
+        fs::remove(legacyPath, ec);
+    }
+
+    if (converted > 0 || failed > 0) {
+        Logger::getInstance().Log(
+            "Converted " + std::to_string(converted) + " chunk files of world '" + worldName + "' to region files" +
+            (failed > 0 ? ", " + std::to_string(failed) + " failed" : ""),
+            failed > 0 ? LogLevel::Warning : LogLevel::Info
+        );
+    }
+    return converted;
+}
+
+void RegionStorage::closeAll() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _open.clear();
+        _lru.clear();
+        _missing.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(_indexMutex);
+    for (auto& [worldName, index] : _indices) {
+        index->save();
+    }
+    _indices.clear();
+}
@@ -1,13 +1,18 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <string>
 
 #include "ChunkController.h"
+#include "ChunkGeneratorRegistry.h"
+#include "TerrainGenerator.h"
 #include "PlayerPos.h"
 #include "Shader.h"
 #include "RayCastHit.h"
 #include "ShadowController.h"
 #include "TimeOfDayController.h"
+#include "WorldInfo.h"
 
 #include "BlockCache.h"
 
@@ -21,23 +26,47 @@ private:
     BlockCache& _blockCache = BlockCache::getInstance();
     int viewDistance = 5;
 
+    std::chrono::steady_clock::time_point _lastAutosave = std::chrono::steady_clock::now();
+    bool _autosaveRunning = false;
+
+    // Spread over frames: each one hands a bounded slice of chunks to ChunkSaver
+    void autosave() {
+        if (!_autosaveRunning) {
+            if (std::chrono::steady_clock::now() - _lastAutosave < AUTOSAVE_INTERVAL) return;
+            _autosaveRunning = true;
+        }
+        if (_chunkController.autosaveStep()) {
+            _autosaveRunning = false;
+            _lastAutosave = std::chrono::steady_clock::now();
+        }
+    }
+
 public:
+    // The seed only applies to a new world, an existing one keeps the seed in its world.info
     World(int seed, std::string worldName)
-        : seed(seed), worldName(worldName), _chunkController(worldName) {
-
+        : seed(WorldInfo::loadOrCreate(worldName, seed).seed), worldName(worldName), _chunkController(worldName) {
+            ChunkGeneratorRegistry::getInstance().set(worldName, std::make_shared<TerrainGenerator>(this->seed));
         }
 
     ~World() {}
 
+    static constexpr std::chrono::seconds AUTOSAVE_INTERVAL{60};
+
     void update(PlayerPos plPos) {
         _chunkController.update(plPos.position, viewDistance);
+        autosave();
     }
 
     void render(Shader& shader, const glm::vec3& sunDirection, const glm::vec3& sunColor) {
         _chunkController.renderAllChunks(shader, sunDirection, sunColor);
     }
 
-    void save() {}
+    // Blocking checkpoint of every dirty loaded chunk, see ChunkController::checkpoint
+    size_t save(const std::function<void(size_t, size_t)>& onProgress = {}) {
+        size_t failed = _chunkController.checkpoint(onProgress);
+        _lastAutosave = std::chrono::steady_clock::now();
+        return failed;
+    }
 
     ChunkController& getChunkController() { return _chunkController; }
     int getSeed() const { return seed; }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "PathProvider.h"
+
+namespace fs = std::filesystem;
+
+// What a world keeps besides its chunks, in world.info next to its regions. Written
+// when the world is created; the game, pregen and worldAnalyzer read the seed from it,
+// so saved changes are always applied over the terrain they were taken against.
+struct WorldInfo {
+    // Seed of a new world when none is chosen
+    static constexpr int DEFAULT_SEED = 12345;
+
+    int seed = DEFAULT_SEED;
+
+    // nullopt when the world has no info file (never created, or saved before the file existed)
+    static std::optional<WorldInfo> load(const std::string& worldName) {
+        std::ifstream file(PathProvider::getInstance().getWorldInfoPath(worldName));
+        if (!file.is_open()) return std::nullopt;
+
+        WorldInfo info;
+        bool hasSeed = false;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string key;
+            if (!(fields >> key)) continue;
+            if (key == "seed") hasSeed = static_cast<bool>(fields >> info.seed);
+        }
+        if (!hasSeed) return std::nullopt;
+        return info;
+    }
+
+    bool save(const std::string& worldName) const {
+        const fs::path path = PathProvider::getInstance().getWorldInfoPath(worldName);
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        std::ofstream file(path, std::ios::trunc);
+        file << "seed " << seed << "\n";
+        return file.good();
+    }
+
+    // The world's info, or a new one with this seed written for it
+    static WorldInfo loadOrCreate(const std::string& worldName, int newSeed) {
+        if (auto info = load(worldName)) return *info;
+        WorldInfo info;
+        info.seed = newSeed;
+        info.save(worldName);
+        return info;
+    }
+};
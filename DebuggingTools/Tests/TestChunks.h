@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cmath>
+
+#include "ChunkBlockStorage.h"
+
+// Synthetic chunk contents shared by the chunk benchmarks. Real terrain comes from
+// TerrainGenerator; these are small, fixed shapes that keep results comparable.
+
+// Thin layered surface over a stone floor, 4-5 block types
+inline Blocks terrainBlock(int x, int y, int z) {
+    int surfaceHeight = static_cast<int>(3.0f + 2.0f * sinf(x * 0.3f) * cosf(z * 0.3f));
+    if (y == 0) return Blocks::Stone;
+    if (y < surfaceHeight - 2) return Blocks::Gneiss;
+    if (y < surfaceHeight - 1) return Blocks::Dirt;
+    if (y == surfaceHeight - 1) return ((x * 7 + z * 13) % 10 == 0) ? Blocks::Sand : Blocks::Dirt;
+    if (y < surfaceHeight && (x + z + y) % 7 != 0) return Blocks::Dirt;
+    return Blocks::Air;
+}
+
+// Every voxel a different type from its neighbour, forces the widest index used in game
+inline Blocks noisyBlock(int x, int y, int z) {
+    return static_cast<Blocks>((x * 31 + y * 17 + z * 7) % static_cast<int>(Blocks::Count));
+}
+
+// One set() per voxel, blockAt(x, y, z) -> Blocks
+template<typename Fn>
+ChunkBlockStorage makeStorage(Fn blockAt) {
+    constexpr int S = ChunkBlockStorage::SIZE;
+    ChunkBlockStorage storage;
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < S; ++y)
+    for (int x = 0; x < S; ++x) {
+        storage.set(ChunkBlockStorage::toIndex(x, y, z), blockAt(x, y, z));
+    }
+    return storage;
+}
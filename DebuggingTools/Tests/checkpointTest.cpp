@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BlockCache.h"
+#include "BlocksIncluder.h"
+#include "ChunkController.h"
+#include "ChunkDataAccess.h"
+#include "ChunkPool.h"
+#include "ChunkSaver.h"
+#include "PathProvider.h"
+#include "RegionFile.h"
+#include "RegionStorage.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Loads chunks into a ChunkController, edits some of them and saves them the two ways a
+// running world does: checkpoint() (World::save, the save on exit) and autosaveStep()
+// through ChunkSaver. Afterwards the edited chunks are clean and read back from reopened
+// region files with their edits, and chunks that were never edited are not on disk.
+// Needs the game's data folder (block definitions) next to the executable.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const std::string WORLD = "CheckpointTest";
+constexpr int S = Chunk::CHUNK_SIZE;
+// More than one autosave step
+constexpr int CHUNKS = static_cast<int>(ChunkController::AUTOSAVE_CHUNKS_PER_STEP) + 44;
+
+ChunkPos chunkAt(int i) {
+    return ChunkPos(i % 10 - 5, (i / 10) % 3 - 1, i / 30 - 5);
+}
+
+// Stone below a height that differs per chunk, so payloads differ
+std::shared_ptr<ChunkBlockStorage> terrainFor(int i) {
+    auto blocks = std::make_shared<ChunkBlockStorage>();
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < 4 + i % 20; ++y)
+    for (int x = 0; x < S; ++x) {
+        blocks->set(ChunkBlockStorage::toIndex(x, y, z), Blocks::Stone);
+    }
+    return blocks;
+}
+
+// A few blocks per chunk, at places that depend on the chunk and the round
+std::vector<std::pair<BlockPos, Blocks>> editsFor(int i, int round) {
+    std::vector<std::pair<BlockPos, Blocks>> edits;
+    for (int e = 0; e < 5; ++e) {
+        const int x = (i * 7 + e * 5 + round) % S;
+        const int y = (i * 3 + e * 11 + round * 13) % S;
+        const int z = (i + e * 17 + round * 5) % S;
+        edits.emplace_back(BlockPos(glm::ivec3(x, y, z)), e % 2 ? Blocks::Sand : Blocks::Air);
+    }
+    return edits;
+}
+
+struct Result {
+    size_t dirty = 0;      // edited chunks still dirty after the save
+    size_t matching = 0;   // edited chunks read back with the blocks they had in memory
+    size_t stray = 0;      // unedited chunks found on disk
+};
+
+// Reads every chunk back through a fresh RegionStorage
+Result verify(ChunkController& controller, const std::vector<bool>& edited) {
+    RegionStorage::getInstance().closeAll();
+    ChunkDataAccess dataAccess;
+    Result result;
+    for (int i = 0; i < CHUNKS; ++i) {
+        const Chunk& live = controller.findChunk(chunkAt(i))->get();
+        auto loaded = dataAccess.loadChunkFromDisk(chunkAt(i), WORLD);
+        if (!edited[i]) {
+            if (loaded) ++result.stray;
+            continue;
+        }
+        if (live.isDirty()) ++result.dirty;
+        if (!loaded) continue;
+
+        bool same = true;
+        for (int idx = 0; idx < ChunkBlockStorage::VOLUME && same; ++idx) {
+            same = (*loaded)->getBlocks().get(idx) == live.getBlocks().get(idx);
+        }
+        if (same) ++result.matching;
+    }
+    return result;
+}
+
+bool report(const std::string& name, const Result& result, size_t edited) {
+    const bool ok = result.dirty == 0 && result.matching == edited && result.stray == 0;
+    std::cout << "[" << name << "] " << result.matching << " of " << edited << " edited chunks read back, "
+              << result.dirty << " still dirty, " << result.stray << " unedited chunks on disk: "
+              << (ok ? "ok" : "WRONG") << "\n";
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    BlockCache::getInstance().loadAll();
+    const fs::path worldPath = PathProvider::getInstance().getWorldsPath() / WORLD;
+    fs::remove_all(worldPath);
+
+    ChunkController controller(WORLD);
+    for (int i = 0; i < CHUNKS; ++i) {
+        auto chunk = ChunkPool::getInstance().acquire(chunkAt(i));
+        chunk->assignBlocks(terrainFor(i));
+        // As if generated: nothing to save until edited
+        chunk->markSaved(chunk->getVersion());
+        controller.getLoadedChunks()[chunkAt(i)] = std::move(chunk);
+    }
+
+    // Two chunks in three edited, then a checkpoint
+    std::vector<bool> edited(CHUNKS, false);
+    for (int i = 0; i < CHUNKS; ++i) {
+        if (i % 3 == 2) continue;
+        controller.getChunk(chunkAt(i))->get().applyEdits(editsFor(i, 0));
+        edited[i] = true;
+    }
+    size_t lastDone = 0;
+    size_t lastTotal = 0;
+    const size_t failed = controller.checkpoint([&](size_t done, size_t total) {
+        lastDone = done;
+        lastTotal = total;
+    });
+    const size_t editedCount = static_cast<size_t>(std::count(edited.begin(), edited.end(), true));
+    std::cout << "[checkpoint] " << failed << " failed, progress ended at " << lastDone << " of " << lastTotal << "\n";
+    bool ok = failed == 0 && lastDone == editedCount && lastTotal == editedCount;
+    ok = report("after checkpoint", verify(controller, edited), editedCount) && ok;
+
+    // Another round of edits on every other chunk, saved by autosave steps through ChunkSaver
+    for (int i = 0; i < CHUNKS; i += 2) {
+        controller.getChunk(chunkAt(i))->get().applyEdits(editsFor(i, 1));
+        edited[i] = true;
+    }
+    int steps = 1;
+    while (!controller.autosaveStep()) ++steps;
+    ChunkSaver::getInstance().flush();
+    std::cout << "[autosave] pass over " << CHUNKS << " chunks in " << steps << " steps\n";
+    const size_t autosavedCount = static_cast<size_t>(std::count(edited.begin(), edited.end(), true));
+    ok = steps == (CHUNKS + ChunkController::AUTOSAVE_CHUNKS_PER_STEP - 1) / ChunkController::AUTOSAVE_CHUNKS_PER_STEP && ok;
+    ok = report("after autosave", verify(controller, edited), autosavedCount) && ok;
+
+    // A chunk whose region file cannot be opened (a directory is in the way): the failed
+    // snapshot stays queued through autosave and checkpoint, and lands once the file can be written
+    {
+        const ChunkPos pos(40, 0, 40);
+        const fs::path regionPath =
+            PathProvider::getInstance().getRegionFilePath(WORLD, RegionFile::toRegionPos(pos));
+        fs::create_directories(regionPath);
+
+        auto chunk = ChunkPool::getInstance().acquire(pos);
+        chunk->assignBlocks(terrainFor(7));
+        chunk->markSaved(chunk->getVersion());
+        controller.getLoadedChunks()[pos] = std::move(chunk);
+        Chunk& live = controller.getChunk(pos)->get();
+        live.applyEdits(editsFor(7, 2));
+
+        while (!controller.autosaveStep()) {}
+        auto& saver = ChunkSaver::getInstance();
+        const size_t requeued = saver.flush();
+        const bool kept = !live.isDirty() && saver.hasPending(pos);
+
+        size_t total = 0;
+        const size_t failedCheckpoint = controller.checkpoint([&](size_t done, size_t all) { total = all; });
+        const bool keptAfterCheckpoint = saver.hasPending(pos);
+
+        fs::remove_all(regionPath);
+        const size_t requeuedAfterFix = saver.flush();
+        RegionStorage::getInstance().closeAll();
+        ChunkDataAccess dataAccess;
+        auto loaded = dataAccess.loadChunkFromDisk(pos, WORLD);
+        bool same = loaded.has_value() && !saver.hasPending(pos);
+        for (int idx = 0; idx < ChunkBlockStorage::VOLUME && same; ++idx) {
+            same = (*loaded)->getBlocks().get(idx) == live.getBlocks().get(idx);
+        }
+
+        const bool failedOk = requeued == 1 && kept && failedCheckpoint == 1 && total == 1 &&
+                              keptAfterCheckpoint && requeuedAfterFix == 0 && same;
+        std::cout << "[failed save] " << requeued << " queued again by flush, " << failedCheckpoint
+                  << " failed in checkpoint, " << (same ? "read back" : "not read back") << " once writable: "
+                  << (failedOk ? "ok" : "WRONG") << "\n";
+        ok = failedOk && ok;
+    }
+
+    // Nothing dirty: a checkpoint writes nothing
+    const size_t failedAgain = controller.checkpoint([&](size_t done, size_t total) { lastTotal = total; });
+    std::cout << "[clean checkpoint] " << lastTotal << " chunks to write\n";
+    ok = failedAgain == 0 && lastTotal == 0 && ok;
+
+    ChunkSaver::getInstance().shutdown();
+    RegionStorage::getInstance().closeAll();
+    controller.getLoadedChunks().clear();
+    fs::remove_all(worldPath);
+    return ok ? 0 : 1;
+}
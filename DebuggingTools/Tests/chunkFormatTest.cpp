@@ -0,0 +1,232 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ChunkBlocksOpaqueData.h"
+#include "ChunkCodec.h"
+#include "TerrainGenerator.h"
+#include "TestChunks.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Bytes per chunk and encode/decode speed of chunk format v1 (u32 id + props
+// per voxel) against v2 (palette + runs or packed indices), with and without zlib.
+// Then v3 (changes over generated terrain) against v2 for growing numbers of edits,
+// and what a parked chunk saves against what bringing it back costs.
+
+namespace {
+
+constexpr int S = ChunkBlockStorage::SIZE;
+using Props = std::vector<std::pair<int, std::string>>;
+
+// The old ChunkDataAccess writer: every non-air voxel carries its properties, "{}" for stateless blocks
+std::string encodeV1(const ChunkBlockStorage& blocks, const Props& props) {
+    std::string out;
+    auto put = [&](uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    put(1);
+    put(ChunkBlockStorage::VOLUME);
+    size_t next = 0;
+    for (int i = 0; i < ChunkBlockStorage::VOLUME; ++i) {
+        Blocks id = blocks.get(i);
+        put(static_cast<uint32_t>(id));
+        if (id == Blocks::Air) continue;
+        std::string p = "{}";
+        while (next < props.size() && props[next].first < i) ++next;
+        if (next < props.size() && props[next].first == i) p = props[next++].second;
+        put(static_cast<uint32_t>(p.size()));
+        out += p;
+    }
+    return out;
+}
+
+template<typename Fn>
+double perSecond(int rounds, Fn fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; ++r) fn();
+    return rounds / std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool sameChunk(const ChunkBlockStorage& a, const DecodedChunk& b, const Props& props) {
+    for (int i = 0; i < ChunkBlockStorage::VOLUME; ++i) {
+        if (a.get(i) != b.blocks.get(i)) return false;
+    }
+    return b.blockProperties == props;
+}
+
+bool report(const std::string& name, const ChunkBlockStorage& blocks, const Props& props) {
+    const std::string v1 = encodeV1(blocks, props);
+    const std::string v2 = ChunkCodec::encode(blocks, props, false);
+    const std::string v2z = ChunkCodec::encode(blocks, props, true);
+
+    DecodedChunk decoded;
+    bool ok = ChunkCodec::decode(v2.data(), v2.size(), decoded) && sameChunk(blocks, decoded, props);
+    ok = ok && ChunkCodec::decode(v2z.data(), v2z.size(), decoded) && sameChunk(blocks, decoded, props);
+    // v1 holds properties of non-air voxels only; the "{}" of stateless blocks is not read back
+    Props v1Props;
+    for (const auto& entry : props) {
+        if (blocks.get(entry.first) != Blocks::Air) v1Props.push_back(entry);
+    }
+    ok = ok && ChunkCodec::decode(v1.data(), v1.size(), decoded) && sameChunk(blocks, decoded, v1Props);
+
+    const int rounds = 200;
+    double v1Decode = perSecond(rounds, [&] { ChunkCodec::decode(v1.data(), v1.size(), decoded); });
+    double v2Encode = perSecond(rounds, [&] { volatile size_t n = ChunkCodec::encode(blocks, props, false).size(); (void)n; });
+    double v2Decode = perSecond(rounds, [&] { ChunkCodec::decode(v2.data(), v2.size(), decoded); });
+    double v2zEncode = perSecond(rounds, [&] { volatile size_t n = ChunkCodec::encode(blocks, props, true).size(); (void)n; });
+    double v2zDecode = perSecond(rounds, [&] { ChunkCodec::decode(v2z.data(), v2z.size(), decoded); });
+
+    // Throughput in MB of v1-equivalent chunk data, so the three columns compare directly
+    const double mb = v1.size() / (1024.0 * 1024.0);
+    std::cout << "[" << name << "] round trip " << (ok ? "ok" : "FAILED") << "\n"
+              << "  v1:        " << v1.size() << " bytes, decode " << static_cast<int>(v1Decode * mb) << " MB/s\n"
+              << "  v2:        " << v2.size() << " bytes, encode " << static_cast<int>(v2Encode * mb)
+              << " MB/s, decode " << static_cast<int>(v2Decode * mb) << " MB/s\n"
+              << "  v2 + zlib: " << v2z.size() << " bytes, encode " << static_cast<int>(v2zEncode * mb)
+              << " MB/s, decode " << static_cast<int>(v2zDecode * mb) << " MB/s\n";
+    return ok;
+}
+
+// Bytes of a full v2 save and a v3 diff save of a generated chunk after `edits` player
+// edits, and whether the diff round trips through regeneration
+bool reportDiff(const TerrainGenerator& generator, int edits) {
+    const ChunkPos pos(3, 0, -2);
+    auto blocks = generator.generateChunk(pos);
+    for (int e = 0; e < edits; ++e) {
+        const int idx = static_cast<int>((e * 2654435761u) % ChunkBlockStorage::VOLUME);
+        blocks->set(idx, blocks->get(idx) == Blocks::Air ? Blocks::Stone : Blocks::Air);
+    }
+
+    const std::string full = ChunkCodec::encode(*blocks, {}, false);
+    const std::string diff = ChunkCodec::encodeDiff(*blocks, *generator.generateChunk(pos), {},
+        generator.getVersion(), generator.getSeed(), false);
+
+    bool ok = edits == 0 ? diff.empty() : false;
+    DecodedChunk decoded;
+    if (!diff.empty() && ChunkCodec::decode(diff.data(), diff.size(), decoded) && decoded.isDiff) {
+        auto restored = generator.generateChunk(pos);
+        for (const auto& [idx, id] : decoded.changes) restored->set(idx, id);
+        ok = true;
+        for (int i = 0; ok && i < ChunkBlockStorage::VOLUME; ++i) ok = restored->get(i) == blocks->get(i);
+    }
+
+    double diffPerSecond = perSecond(200, [&] {
+        volatile size_t n = ChunkCodec::encodeDiff(*blocks, *generator.generateChunk(pos), {},
+            generator.getVersion(), generator.getSeed(), false).size();
+        (void)n;
+    });
+
+    std::cout << "[diff, " << edits << " edits] round trip " << (ok ? "ok" : "FAILED")
+              << ", v2 " << full.size() << " bytes, v3 " << diff.size() << " bytes"
+              << ", regenerate + diff " << static_cast<int>(1e6 / diffPerSecond) << " us\n";
+    return ok;
+}
+
+// A parked chunk (Chunk::park) keeps neither storage nor opacity masks; the first access
+// decodes its payload again from the region mapping
+void reportParking(const TerrainGenerator& generator) {
+    const ChunkPos pos(3, 0, -2);
+    auto blocks = generator.generateChunk(pos);
+    for (int e = 0; e < 20; ++e) {
+        blocks->set(static_cast<int>((e * 2654435761u) % ChunkBlockStorage::VOLUME), Blocks::Stone);
+    }
+    const size_t resident = blocks->getMemoryUsage() + ChunkBlocksOpaqueData::ROWS * sizeof(uint32_t);
+
+    const std::string full = ChunkCodec::encode(*blocks, {}, false);
+    const std::string diff = ChunkCodec::encodeDiff(*blocks, *generator.generateChunk(pos), {},
+        generator.getVersion(), generator.getSeed(), false);
+
+    ChunkBlocksOpaqueData opacity;
+    auto rebuildOpacity = [&](const ChunkBlockStorage& storage) {
+        for (int z = 0; z < S; ++z) {
+            for (int y = 0; y < S; ++y) {
+                uint32_t row = 0;
+                for (int x = 0; x < S; ++x) {
+                    row |= (storage.get(ChunkBlockStorage::toIndex(x, y, z)) != Blocks::Air ? 1u : 0u) << x;
+                }
+                opacity.setRow(y, z, row);
+            }
+        }
+    };
+
+    double fullPerSecond = perSecond(500, [&] {
+        DecodedChunk decoded;
+        ChunkCodec::decode(full.data(), full.size(), decoded);
+        rebuildOpacity(decoded.blocks);
+    });
+    double diffPerSecond = perSecond(200, [&] {
+        DecodedChunk decoded;
+        ChunkCodec::decode(diff.data(), diff.size(), decoded);
+        auto restored = generator.generateChunk(pos);
+        for (const auto& [idx, id] : decoded.changes) restored->set(idx, id);
+        rebuildOpacity(*restored);
+    });
+
+    std::cout << "[parked terrain chunk] resident " << resident << " bytes -> 0"
+              << ", reload from v2 " << static_cast<int>(1e6 / fullPerSecond) << " us"
+              << ", from v3 " << static_cast<int>(1e6 / diffPerSecond) << " us\n";
+}
+
+// Compressed payloads whose announced body size is out of range, or whose stream inflates
+// past it, are rejected without inflating them
+bool reportCorrupt() {
+    std::string payload = ChunkCodec::encode(makeStorage(terrainBlock), {}, true);
+    DecodedChunk decoded;
+    const bool intact = ChunkCodec::decode(payload.data(), payload.size(), decoded);
+
+    // u32 version | u8 flags | u32 body size
+    const uint32_t huge = 0x7FFFFFFF;
+    std::memcpy(&payload[5], &huge, sizeof(huge));
+    const bool hugeRejected = !ChunkCodec::decode(payload.data(), payload.size(), decoded);
+
+    // 64 MB of zeros announced as 64 KB
+    std::string zeros(64 * 1024 * 1024, '\0');
+    int compressedSize = 0;
+    unsigned char* compressed = stbi_zlib_compress(reinterpret_cast<unsigned char*>(zeros.data()),
+        static_cast<int>(zeros.size()), &compressedSize, 5);
+    std::string bomb;
+    const uint32_t version = ChunkCodec::VERSION;
+    const uint32_t announced = 64 * 1024;
+    bomb.append(reinterpret_cast<const char*>(&version), sizeof(version));
+    bomb.push_back(static_cast<char>(ChunkCodec::FLAG_ZLIB));
+    bomb.append(reinterpret_cast<const char*>(&announced), sizeof(announced));
+    bomb.append(reinterpret_cast<const char*>(compressed), static_cast<size_t>(compressedSize));
+    std::free(compressed);
+    const bool bombRejected = !ChunkCodec::decode(bomb.data(), bomb.size(), decoded);
+
+    const bool ok = intact && hugeRejected && bombRejected;
+    std::cout << "[corrupt] 2 GB body size " << (hugeRejected ? "rejected" : "ACCEPTED") << ", " << bomb.size()
+              << " bytes inflating to 64 MB " << (bombRejected ? "rejected" : "ACCEPTED") << "\n";
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    ok = report("all dirt", makeStorage([](int, int, int) { return Blocks::Dirt; }), {}) && ok;
+    ok = report("surface terrain", makeStorage(terrainBlock), {}) && ok;
+    ok = report("all types mixed", makeStorage(noisyBlock), {}) && ok;
+
+    Props props;
+    for (int i = 0; i < ChunkBlockStorage::VOLUME; i += 331) props.emplace_back(i, "{\"facing\":\"north\"}");
+    ok = report("terrain + 100 block properties", makeStorage(terrainBlock), props) && ok;
+
+    std::string air = ChunkCodec::encode(ChunkBlockStorage(), {}, false);
+    std::cout << "[all air] " << air.size() << " byte\n";
+
+    TerrainGenerator generator(12345);
+    for (int edits : { 0, 1, 20, 500, 5000 }) {
+        ok = reportDiff(generator, edits) && ok;
+    }
+    reportParking(generator);
+    ok = reportCorrupt() && ok;
+    return ok ? 0 : 1;
+}
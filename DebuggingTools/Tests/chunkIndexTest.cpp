@@ -0,0 +1,120 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "ChunkIndex.h"
+#include "PathProvider.h"
+#include "RegionFile.h"
+
+// Writes chunks straight into a world's region files, without an index, and checks
+// that ChunkIndex rebuilds the same positions from the region headers: when its file
+// is missing, when the file is damaged, and after a set() that was never saved (the
+// change removes the file, so a crash before save() ends in a rebuild, not in a stale
+// index). Files in the regions folder that are not regions are skipped.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const std::string WORLD = "ChunkIndexTest";
+
+using Key = std::tuple<int, int, int>;
+
+Key keyOf(const ChunkPos& pos) {
+    return { pos.position.x, pos.position.y, pos.position.z };
+}
+
+// Spread over several regions on both sides of the origin
+ChunkPos chunkAt(int i) {
+    return ChunkPos(i % 40 - 20, (i / 40) % 5 - 2, i / 200 - 3);
+}
+
+std::set<Key> indexed(const ChunkIndex& index) {
+    std::set<Key> keys;
+    for (const auto& pos : index.getPositions()) keys.insert(keyOf(pos));
+    return keys;
+}
+
+bool matches(const std::string& name, const ChunkIndex& index, const std::set<Key>& expected) {
+    bool same = index.size() == expected.size() && indexed(index) == expected;
+    for (int i = 0; i < 1200; ++i) {
+        same = same && index.contains(chunkAt(i)) == expected.contains(keyOf(chunkAt(i)));
+    }
+    std::cout << "[" << name << "] " << index.size() << " of " << expected.size() << " chunks, positions "
+              << (same ? "match" : "DIFFER") << "\n";
+    return same;
+}
+
+} // namespace
+
+int main() {
+    auto& paths = PathProvider::getInstance();
+    const fs::path worldPath = paths.getWorldsPath() / WORLD;
+    const fs::path regionsPath = paths.getWorldRegionsPath(WORLD);
+    fs::remove_all(worldPath);
+    fs::create_directories(regionsPath);
+
+    // Two of every three chunks stored, every seventh of those erased again
+    std::set<Key> expected;
+    {
+        std::map<Key, std::unique_ptr<RegionFile>> regions;
+        auto regionFor = [&](const ChunkPos& pos) -> RegionFile& {
+            const glm::ivec3 r = RegionFile::toRegionPos(pos);
+            auto& region = regions[{ r.x, r.y, r.z }];
+            if (!region) region = std::make_unique<RegionFile>(paths.getRegionFilePath(WORLD, r));
+            return *region;
+        };
+        for (int i = 0; i < 1200; ++i) {
+            if (i % 3 == 0) continue;
+            const std::string payload = "chunk " + std::to_string(i) + std::string(i % 600, 'x');
+            regionFor(chunkAt(i)).write(chunkAt(i), payload.data(), payload.size());
+            expected.insert(keyOf(chunkAt(i)));
+        }
+        for (int i = 1; i < 1200; i += 7) {
+            if (i % 3 == 0) continue;
+            regionFor(chunkAt(i)).erase(chunkAt(i));
+            expected.erase(keyOf(chunkAt(i)));
+        }
+    }
+
+    // Not regions: other names, a malformed name, a file too short for a header
+    std::ofstream(regionsPath / "notes.txt") << "not a region";
+    std::ofstream(regionsPath / "Region_1_2") << "no z";
+    std::ofstream(regionsPath / "Region_9_9_9") << "too short";
+
+    bool ok = true;
+    {
+        ChunkIndex index(WORLD);
+        ok = matches("rebuilt from headers", index, expected) && ok;
+    }
+    const fs::path indexPath = paths.getChunkIndexPath(WORLD);
+    ok = fs::exists(indexPath) && ok;
+    {
+        ChunkIndex index(WORLD);
+        ok = matches("loaded from the index file", index, expected) && ok;
+
+        // A change that never reaches save() must not leave the old file behind
+        index.set(ChunkPos(100, 100, 100), true);
+        const bool removed = !fs::exists(indexPath);
+        std::cout << "[unsaved change] index file " << (removed ? "removed" : "STILL THERE") << "\n";
+        ok = removed && ok;
+    }
+    {
+        ChunkIndex index(WORLD);
+        ok = matches("rebuilt after an unsaved change", index, expected) && ok;
+    }
+
+    std::ofstream(indexPath, std::ios::binary | std::ios::trunc) << "MOC";
+    {
+        ChunkIndex index(WORLD);
+        ok = matches("rebuilt from a damaged file", index, expected) && ok;
+    }
+
+    fs::remove_all(worldPath);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ChunkMeshCache.h"
+#include "PathProvider.h"
+
+// Stores meshes under one key and looks them up with that key and with others, before
+// and after the writer has put them on disk and the folder was indexed again from the
+// file headers. A lookup with another key has to miss and leave the cached mesh in
+// place, a newer store replaces the key, and files of another format are removed.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const std::string WORLD = "MeshCacheTest";
+constexpr int CHUNKS = 16;
+
+ChunkPos chunkAt(int i) {
+    return ChunkPos(i % 4, 0, i / 4);
+}
+
+void meshFor(int i, uint64_t salt, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    vertices.assign(4 * (i + 1), Vertex{});
+    for (size_t v = 0; v < vertices.size(); ++v) {
+        vertices[v].position = glm::vec3(static_cast<float>(i), static_cast<float>(v), static_cast<float>(salt));
+    }
+    indices.assign(6 * (i + 1), static_cast<unsigned int>((i + salt) % vertices.size()));
+}
+
+bool sameMesh(const std::vector<Vertex>& a, const std::vector<Vertex>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Vertex)) == 0;
+}
+
+// Chunks whose lookup with keyFor(i) hits and returns the mesh meshFor(i, salt) stored
+template<typename KeyFn>
+int countHits(ChunkMeshCache& cache, KeyFn keyFor, uint64_t salt) {
+    int hits = 0;
+    for (int i = 0; i < CHUNKS; ++i) {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<Vertex> expectedVertices;
+        std::vector<unsigned int> expectedIndices;
+        meshFor(i, salt, expectedVertices, expectedIndices);
+        if (cache.load(chunkAt(i), keyFor(i), vertices, indices) &&
+            sameMesh(vertices, expectedVertices) && indices == expectedIndices) {
+            ++hits;
+        }
+    }
+    return hits;
+}
+
+} // namespace
+
+int main() {
+    auto& cache = ChunkMeshCache::getInstance();
+    const fs::path worldPath = PathProvider::getInstance().getWorldsPath() / WORLD;
+    const fs::path folder = PathProvider::getInstance().getWorldMeshCachePath(WORLD);
+    fs::remove_all(worldPath);
+
+    auto key = [](int i) { return 1000 + static_cast<uint64_t>(i); };
+    auto otherKey = [](int i) { return 5000 + static_cast<uint64_t>(i); };
+
+    cache.open(WORLD);
+    for (int i = 0; i < CHUNKS; ++i) {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        meshFor(i, 0, vertices, indices);
+        cache.store(chunkAt(i), key(i), vertices, indices);
+    }
+    const int pendingHits = countHits(cache, key, 0);
+    const int pendingMisses = CHUNKS - countHits(cache, otherKey, 0);
+
+    // Reopening waits for the writer and indexes the folder again from the file headers
+    cache.open(WORLD);
+    const int diskMisses = CHUNKS - countHits(cache, otherKey, 0);
+    const int diskHits = countHits(cache, key, 0);
+    std::cout << "[same key] " << pendingHits << " of " << CHUNKS << " hits before the write, "
+              << diskHits << " after reopening\n"
+              << "[other key] " << pendingMisses << " of " << CHUNKS << " misses before the write, "
+              << diskMisses << " after reopening\n";
+
+    // A newer mesh of chunk 0 under another key replaces the old one
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        meshFor(0, 7, vertices, indices);
+        cache.store(chunkAt(0), otherKey(0), vertices, indices);
+    }
+    cache.open(WORLD);
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    const bool oldKeyMisses = !cache.load(chunkAt(0), key(0), vertices, indices);
+    const bool newKeyHits = cache.load(chunkAt(0), otherKey(0), vertices, indices);
+    std::cout << "[replaced] old key " << (oldKeyMisses ? "misses" : "HITS") << ", new key "
+              << (newKeyHits ? "hits" : "MISSES") << "\n";
+
+    // Another format version and a file too short for a header: both go on the next open
+    {
+        std::ofstream older(folder / "9_0_9.mesh", std::ios::binary);
+        const uint32_t header[2] = { 0x48534D4D, ChunkMeshCache::FORMAT_VERSION - 1 };
+        older.write(reinterpret_cast<const char*>(header), sizeof(header));
+        older.write(std::string(64, '\0').data(), 64);
+        std::ofstream(folder / "9_0_8.mesh", std::ios::binary) << "mesh";
+    }
+    cache.open(WORLD);
+    cache.open(WORLD);
+    const bool foreignRemoved = !fs::exists(folder / "9_0_9.mesh") && !fs::exists(folder / "9_0_8.mesh");
+    std::cout << "[other format] files " << (foreignRemoved ? "removed" : "KEPT") << "\n";
+
+    cache.setEnabled(false);
+    const bool disabledMisses = !cache.load(chunkAt(1), key(1), vertices, indices);
+    cache.setEnabled(true);
+
+    const ChunkMeshCacheStats stats = cache.getStats();
+    std::cout << "[stats] " << stats.lookups << " lookups, " << stats.hits << " hits, " << stats.stores
+              << " stores, " << stats.entries << " entries\n";
+
+    cache.shutdown();
+    fs::remove_all(worldPath);
+
+    const bool ok = pendingHits == CHUNKS && diskHits == CHUNKS && pendingMisses == CHUNKS && diskMisses == CHUNKS &&
+                    oldKeyMisses && newKeyHits && foreignRemoved && disabledMisses;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ChunkMeshScheduler.h"
+#include "ThreadPool.h"
+
+// Runs ChunkMeshScheduler against a stand-in ChunkMeshBuilder::run, so no world, block
+// models or mesh cache are needed:
+// - priority jobs come back from the collect() that first sees them, built on the main
+//   thread when every worker is busy;
+// - each worker takes the queued jobs nearest first;
+// - runners pushed out of a full ThreadPool queue (a burst of chunk loads) are noticed
+//   and replaced;
+// - shutdown drops the queued jobs without building them, returns without waiting out
+//   a timeout, and later submits are dropped.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int JOBS = 48;
+
+std::mutex buildsMutex;
+// Thread and distance of every build, in the order they ran
+std::vector<std::pair<std::thread::id, int>> builds;
+
+size_t buildCount() {
+    std::lock_guard<std::mutex> lock(buildsMutex);
+    return builds.size();
+}
+
+double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::unique_ptr<ChunkMeshJob> makeJob(int distance, bool priority = false) {
+    auto job = std::make_unique<ChunkMeshJob>();
+    job->pos = ChunkPos(distance, 0, 0);
+    job->distance = distance;
+    job->priority = priority;
+    return job;
+}
+
+// Submitted out of order: 0, 17, 34, 3, ...
+void submitQueued(ChunkMeshScheduler& scheduler) {
+    for (int i = 0; i < JOBS; ++i) scheduler.submit(makeJob(i * 17 % JOBS));
+}
+
+// Keeps every worker busy until release is set
+void holdWorkers(ThreadPool& pool, std::atomic<bool>& release) {
+    std::atomic<size_t> held{0};
+    for (size_t i = 0; i < pool.getWorkerCount(); ++i) {
+        pool.enqueueChunkTask([&] {
+            ++held;
+            while (!release.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        });
+    }
+    while (held.load() < pool.getWorkerCount()) std::this_thread::yield();
+}
+
+// Calls collect() until count jobs came back or two seconds passed
+size_t collectUntil(ChunkMeshScheduler& scheduler, size_t count) {
+    size_t collected = 0;
+    const auto start = Clock::now();
+    while (collected < count && millisSince(start) < 2000.0) {
+        collected += scheduler.collect().size();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return collected;
+}
+
+} // namespace
+
+void ChunkMeshBuilder::run(ChunkMeshJob& job) {
+    job.vertices.assign(4, Vertex{});
+    std::lock_guard<std::mutex> lock(buildsMutex);
+    builds.emplace_back(std::this_thread::get_id(), job.distance);
+}
+
+int main() {
+    auto& pool = ThreadPool::getInstance();
+    auto& scheduler = ChunkMeshScheduler::getInstance();
+    const std::thread::id mainThread = std::this_thread::get_id();
+    bool ok = true;
+
+    // Priority jobs while every worker is held: the same collect() builds them here
+    std::atomic<bool> release{false};
+    holdWorkers(pool, release);
+    submitQueued(scheduler);
+    for (int i = 0; i < 3; ++i) scheduler.submit(makeJob(1000 + i, true));
+    const auto finished = scheduler.collect();
+    bool priorityOnMain = finished.size() == 3;
+    for (const auto& job : finished) priorityOnMain = priorityOnMain && job->priority;
+    for (const auto& [thread, distance] : builds) priorityOnMain = priorityOnMain && thread == mainThread;
+    std::cout << "[priority] " << finished.size() << " jobs back from the first collect, "
+              << (priorityOnMain ? "all priority, built on the main thread" : "NOT THE PRIORITY ONES") << "\n";
+    ok = priorityOnMain && ok;
+
+    // Queued jobs once the workers are free: each worker's builds nearest first
+    const size_t before = buildCount();
+    release = true;
+    const size_t collected = collectUntil(scheduler, JOBS);
+    std::map<std::thread::id, int> lastDistance;
+    bool nearestFirst = true;
+    {
+        std::lock_guard<std::mutex> lock(buildsMutex);
+        for (size_t i = before; i < builds.size(); ++i) {
+            auto [it, first] = lastDistance.emplace(builds[i].first, builds[i].second);
+            nearestFirst = nearestFirst && (first || it->second <= builds[i].second);
+            it->second = builds[i].second;
+        }
+    }
+    std::cout << "[nearest first] " << collected << " of " << JOBS << " jobs on " << lastDistance.size()
+              << " workers, " << (nearestFirst ? "each in distance order" : "OUT OF ORDER") << "\n";
+    ok = collected == JOBS && nearestFirst && ok;
+
+    // More tasks than the queue holds: the runners collect() queued are the oldest and go first
+    release = false;
+    holdWorkers(pool, release);
+    submitQueued(scheduler);
+    size_t afterFlood = scheduler.collect().size();
+    for (int i = 0; i < 1000; ++i) pool.enqueueChunkTask([] {});
+    release = true;
+    const auto floodStart = Clock::now();
+    afterFlood += collectUntil(scheduler, JOBS - afterFlood);
+    std::cout << "[runners pushed out] " << afterFlood << " of " << JOBS << " jobs finished in "
+              << static_cast<int>(millisSince(floodStart)) << " ms\n";
+    ok = afterFlood == JOBS && ok;
+
+    // Shutdown with jobs queued and runners waiting behind the held workers
+    release = false;
+    holdWorkers(pool, release);
+    submitQueued(scheduler);
+    scheduler.collect();
+    const size_t builtBeforeShutdown = buildCount();
+    std::thread releaser([&] {
+        while (scheduler.getStats().queued > 0) std::this_thread::yield();
+        release = true;
+    });
+    const auto shutdownStart = Clock::now();
+    scheduler.shutdown();
+    const double shutdownMillis = millisSince(shutdownStart);
+    releaser.join();
+
+    scheduler.submit(makeJob(0));
+    const bool dropped = buildCount() == builtBeforeShutdown && scheduler.getStats().queued == 0 &&
+                         scheduler.collect().empty();
+    std::cout << "[shutdown] returned in " << static_cast<int>(shutdownMillis) << " ms, queued jobs "
+              << (dropped ? "dropped" : "STILL BUILT") << "\n";
+    ok = dropped && shutdownMillis < 1000.0 && ok;
+
+    return ok ? 0 : 1;
+}
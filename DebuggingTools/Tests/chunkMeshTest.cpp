@@ -0,0 +1,233 @@
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "BlockCache.h"
+#include "ChunkMesher.h"
+#include "TerrainGenerator.h"
+#include "TextureManager.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Vertices, indices and build time of the per-face mesher against greedy meshing, on
+// generated terrain and on a few synthetic chunks. Both modes have to cover the same
+// area with each texture in each direction. Needs the game's data folder (models)
+// next to the executable; the atlas layout is made up, no GL context is created.
+//
+// The checkerboard is the worst case for output, not for culling: half its blocks show
+// all six faces, 393k vertices of 48 bytes. No mesher writes that in under a millisecond,
+// so its time is held against a plain copy of the same vertices and indices ("copy"),
+// and the target is to stay within a small factor of that copy, with greedy no slower
+// than faces when nothing merges.
+
+namespace {
+
+constexpr int S = ChunkMeshSource::SIZE;
+
+struct MeshChunk {
+    glm::ivec3 pos;
+    std::shared_ptr<const ChunkBlockStorage> blocks;
+    ChunkBlocksOpaqueData opacity;
+};
+
+ChunkBlocksOpaqueData computeOpacity(const ChunkBlockStorage& blocks) {
+    ChunkBlocksOpaqueData opacity;
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < S; ++y) {
+        uint32_t row = 0;
+        for (int x = 0; x < S; ++x) {
+            row |= (BlockCache::getInstance().getBlockInfo(blocks.get(ChunkBlockStorage::toIndex(x, y, z))).isOpaque ? 1u : 0u) << x;
+        }
+        opacity.setRow(y, z, row);
+    }
+    return opacity;
+}
+
+// Same layers as ChunkMeshBuilder::gatherBorders, from neighbours found in chunks
+ChunkMeshSource makeSource(const MeshChunk& chunk, const std::map<std::tuple<int, int, int>, MeshChunk>& chunks) {
+    static const glm::ivec3 offsets[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    ChunkMeshSource source;
+    source.chunkPos = chunk.pos;
+    source.blocks = chunk.blocks.get();
+    source.opacity = &chunk.opacity;
+    for (int i = 0; i < 6; ++i) {
+        const glm::ivec3 d = offsets[i];
+        const glm::ivec3 n = chunk.pos + d;
+        auto it = chunks.find({ n.x, n.y, n.z });
+        if (it == chunks.end()) continue;
+        const ChunkBlocksOpaqueData& opacity = it->second.opacity;
+        for (int a = 0; a < S; ++a) {
+            if (d.x != 0) {
+                for (int y = 0; y < S; ++y) source.borders[i][a] |= ((opacity.getRow(y, a) >> (d.x > 0 ? 0 : S - 1)) & 1u) << y;
+            } else if (d.y != 0) {
+                source.borders[i][a] = opacity.getRow(d.y > 0 ? 0 : S - 1, a);
+            } else {
+                source.borders[i][a] = opacity.getRow(a, d.z > 0 ? 0 : S - 1);
+            }
+        }
+    }
+    return source;
+}
+
+// Area covered per direction and texture, in block faces
+using Coverage = std::map<std::tuple<int, int, int, float, float>, double>;
+
+Coverage coverage(const std::vector<Vertex>& vertices) {
+    Coverage result;
+    for (size_t q = 0; q + 3 < vertices.size(); q += 4) {
+        const glm::vec3 n = vertices[q].normal;
+        const double area = glm::length(glm::cross(vertices[q + 1].position - vertices[q].position,
+                                                   vertices[q + 3].position - vertices[q].position));
+        result[{ static_cast<int>(n.x), static_cast<int>(n.y), static_cast<int>(n.z),
+                 vertices[q].atlasRect.x, vertices[q].atlasRect.y }] += area;
+    }
+    return result;
+}
+
+bool report(const std::string& name, const std::vector<ChunkMeshSource>& sources) {
+    struct Result {
+        size_t vertices = 0;
+        size_t indices = 0;
+        double microsPerChunk = 0;
+        double copyMicrosPerChunk = 0;
+        Coverage covered;
+    };
+
+    auto run = [&](MeshingMode mode) {
+        Result result;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        for (const auto& source : sources) {
+            vertices.clear();
+            indices.clear();
+            ChunkMesher::build(source, mode, vertices, indices);
+            result.vertices += vertices.size();
+            result.indices += indices.size();
+            for (const auto& [key, area] : coverage(vertices)) result.covered[key] += area;
+        }
+
+        // Whole rounds for at least half a second
+        int rounds = 0;
+        double micros = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        while (micros < 500000.0) {
+            for (const auto& source : sources) {
+                vertices.clear();
+                indices.clear();
+                ChunkMesher::build(source, mode, vertices, indices);
+            }
+            ++rounds;
+            micros = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        result.microsPerChunk = micros / (rounds * sources.size());
+
+        // Copying the meshes into buffers of their size, the least any mesher pays for the output
+        std::vector<std::pair<std::vector<Vertex>, std::vector<unsigned int>>> meshes;
+        for (const auto& source : sources) {
+            vertices.clear();
+            indices.clear();
+            ChunkMesher::build(source, mode, vertices, indices);
+            meshes.emplace_back(vertices, indices);
+        }
+        rounds = 0;
+        micros = 0;
+        start = std::chrono::high_resolution_clock::now();
+        while (micros < 200000.0) {
+            for (const auto& [meshVertices, meshIndices] : meshes) {
+                vertices.clear();
+                indices.clear();
+                vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+                indices.insert(indices.end(), meshIndices.begin(), meshIndices.end());
+            }
+            ++rounds;
+            micros = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        result.copyMicrosPerChunk = micros / (rounds * sources.size());
+        return result;
+    };
+
+    const Result faces = run(MeshingMode::Faces);
+    const Result greedy = run(MeshingMode::Greedy);
+
+    bool same = faces.covered.size() == greedy.covered.size();
+    for (const auto& [key, area] : faces.covered) {
+        auto it = greedy.covered.find(key);
+        same = same && it != greedy.covered.end() && std::abs(it->second - area) < 1e-3;
+    }
+
+    std::cout << "[" << name << "] " << sources.size() << " chunks, coverage " << (same ? "ok" : "DIFFERS") << "\n"
+              << "  faces:  " << faces.vertices << " vertices, " << faces.indices << " indices, "
+              << static_cast<int>(faces.microsPerChunk) << " us per chunk (copy "
+              << static_cast<int>(faces.copyMicrosPerChunk) << " us)\n"
+              << "  greedy: " << greedy.vertices << " vertices, " << greedy.indices << " indices, "
+              << static_cast<int>(greedy.microsPerChunk) << " us per chunk (copy "
+              << static_cast<int>(greedy.copyMicrosPerChunk) << " us), "
+              << (faces.vertices == 0 ? 0 : greedy.vertices * 100 / faces.vertices) << "% of the vertices\n";
+    return same;
+}
+
+template<typename Fn>
+bool reportSingle(const std::string& name, Fn blockAt) {
+    auto blocks = std::make_shared<ChunkBlockStorage>();
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < S; ++y)
+    for (int x = 0; x < S; ++x) {
+        blocks->set(ChunkBlockStorage::toIndex(x, y, z), blockAt(x, y, z));
+    }
+    MeshChunk chunk{ glm::ivec3(0), blocks, computeOpacity(*blocks) };
+    return report(name, { makeSource(chunk, {}) });
+}
+
+// Every model texture gets a 16 px cell of a made-up atlas, as TextureManager::bindTextures lays them out
+void fakeAtlas() {
+    auto& regions = TextureManager::getInstance().getAtlasRegions();
+    int index = 0;
+    for (int b = 0; b < static_cast<int>(Blocks::Count); ++b) {
+        for (const auto& [key, texture] : BlockCache::getInstance().getBlockModel(static_cast<Blocks>(b)).textures) {
+            if (regions.contains(texture + ".png")) continue;
+            const float u0 = (index % 8) * 18 + 2;
+            const float v0 = (index / 8) * 18 + 2;
+            regions[texture + ".png"] = AtlasRegion{ u0 / 256.0f, v0 / 256.0f, (u0 + 16) / 256.0f, (v0 + 16) / 256.0f };
+            ++index;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    BlockCache::getInstance().loadAll();
+    fakeAtlas();
+    BlockCache::getInstance().bakeModels(TextureManager::getInstance().getAtlasRegions());
+
+    // 8 x 8 chunks of terrain, meshed with the air layers above and below as neighbours
+    TerrainGenerator generator(12345);
+    std::map<std::tuple<int, int, int>, MeshChunk> chunks;
+    for (int x = -1; x <= 8; ++x)
+    for (int y = -1; y <= 1; ++y)
+    for (int z = -1; z <= 8; ++z) {
+        std::shared_ptr<const ChunkBlockStorage> blocks = generator.generateChunk(ChunkPos(x, y, z));
+        chunks[{ x, y, z }] = MeshChunk{ glm::ivec3(x, y, z), blocks, computeOpacity(*blocks) };
+    }
+    std::vector<ChunkMeshSource> terrain;
+    for (int x = 0; x < 8; ++x)
+    for (int z = 0; z < 8; ++z) {
+        terrain.push_back(makeSource(chunks.at({ x, 0, z }), chunks));
+    }
+    bool ok = report("generated terrain", terrain);
+
+    ok = reportSingle("flat stone floor", [](int, int y, int) { return y < 16 ? Blocks::Stone : Blocks::Air; }) && ok;
+    ok = reportSingle("stone and dirt stripes", [](int x, int y, int) { return y < 16 ? (x % 2 ? Blocks::Stone : Blocks::Dirt) : Blocks::Air; }) && ok;
+    ok = reportSingle("checkerboard", [](int x, int y, int z) { return (x + y + z) % 2 ? Blocks::Stone : Blocks::Air; }) && ok;
+    return ok ? 0 : 1;
+}
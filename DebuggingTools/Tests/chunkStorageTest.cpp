@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ChunkBlockStorage.h"
+#include "ChunkBlocksOpaqueData.h"
+#include "TestChunks.h"
+
+// Compares the palette storage against the old std::vector<std::shared_ptr<Block>>
+// layout: bytes per chunk and getBlock throughput.
+
+namespace {
+
+constexpr int S = ChunkBlockStorage::SIZE;
+
+struct LegacyBlock {
+    virtual ~LegacyBlock() = default;
+    virtual Blocks getBlockId() const = 0;
+};
+
+struct LegacyTypedBlock : LegacyBlock {
+    explicit LegacyTypedBlock(Blocks id) : id(id) {}
+    Blocks getBlockId() const override { return id; }
+    Blocks id;
+};
+
+struct LegacyChunk {
+    std::vector<std::shared_ptr<LegacyBlock>> blocks;
+    size_t heapBytes = 0;
+
+    template<typename Fn>
+    explicit LegacyChunk(Fn blockAt) : blocks(ChunkBlockStorage::VOLUME) {
+        auto air = std::make_shared<LegacyTypedBlock>(Blocks::Air);
+        heapBytes = blocks.capacity() * sizeof(std::shared_ptr<LegacyBlock>);
+        for (int z = 0; z < S; ++z)
+        for (int y = 0; y < S; ++y)
+        for (int x = 0; x < S; ++x) {
+            Blocks id = blockAt(x, y, z);
+            auto& slot = blocks[ChunkBlockStorage::toIndex(x, y, z)];
+            if (id == Blocks::Air) {
+                slot = air;
+            } else {
+                slot = std::make_shared<LegacyTypedBlock>(id);
+                // make_shared control block + object, rounded to a typical 16 byte heap bucket
+                heapBytes += (sizeof(LegacyTypedBlock) + 16 + 15) & ~size_t(15);
+            }
+        }
+    }
+};
+
+template<typename Fn>
+double measureMops(Fn readAll) {
+    constexpr int passes = 200;
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t checksum = 0;
+    for (int p = 0; p < passes; ++p) {
+        checksum += readAll();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    volatile uint64_t sink = checksum;
+    (void)sink;
+    return (double(passes) * ChunkBlockStorage::VOLUME) / seconds / 1e6;
+}
+
+template<typename Fn>
+bool report(const std::string& name, Fn blockAt) {
+    LegacyChunk legacy(blockAt);
+    ChunkBlockStorage storage = makeStorage(blockAt);
+
+    bool same = true;
+    for (int i = 0; i < ChunkBlockStorage::VOLUME; ++i) {
+        same = same && legacy.blocks[i]->getBlockId() == storage.get(i);
+    }
+
+    double legacyMops = measureMops([&]() {
+        uint64_t sum = 0;
+        for (const auto& b : legacy.blocks) sum += static_cast<uint64_t>(b->getBlockId());
+        return sum;
+    });
+    double storageMops = measureMops([&]() {
+        uint64_t sum = 0;
+        for (int i = 0; i < ChunkBlockStorage::VOLUME; ++i) sum += static_cast<uint64_t>(storage.get(i));
+        return sum;
+    });
+
+    std::cout << "[" << name << "] "
+              << (same ? "contents match" : "CONTENTS DIFFER") << "\n"
+              << "  before: " << legacy.heapBytes << " bytes/chunk, getBlock " << legacyMops << " M/s\n"
+              << "  after:  " << storage.getMemoryUsage() << " bytes/chunk (" << storage.getBitsPerEntry()
+              << " bits, palette " << storage.getPalette().size() << (storage.isUniform() ? ", uniform" : "")
+              << "), getBlock " << storageMops << " M/s\n";
+    return same;
+}
+
+// An all-air column at view distance 5 is 11^3 chunks
+void reportAirCube() {
+    constexpr int chunks = 11 * 11 * 11;
+    std::vector<ChunkBlockStorage> cube(chunks);
+    size_t bytes = 0;
+    for (const auto& storage : cube) bytes += storage.getMemoryUsage();
+    std::cout << "[air cube] " << chunks << " chunks: " << bytes / 1024 << " KB of block storage (was "
+              << size_t(chunks) * ChunkBlockStorage::VOLUME * sizeof(std::shared_ptr<LegacyBlock>) / (1024 * 1024) << " MB)\n";
+}
+
+// First differing write densifies, restoring the block collapses back to uniform
+bool reportUniformTransitions() {
+    ChunkBlockStorage storage;
+    storage.set(ChunkBlockStorage::toIndex(5, 5, 5), Blocks::Stone);
+    bool dense = !storage.isUniform() && storage.get(ChunkBlockStorage::toIndex(5, 5, 5)) == Blocks::Stone;
+    storage.set(ChunkBlockStorage::toIndex(5, 5, 5), Blocks::Air);
+    bool uniformAgain = storage.isUniform() && storage.getPackedData().empty();
+    std::cout << "[uniform] densify on write: " << (dense ? "ok" : "FAILED")
+              << ", collapse on restore: " << (uniformAgain ? "ok" : "FAILED") << "\n";
+    return dense && uniformAgain;
+}
+
+// Same copy-on-write rule as Chunk::snapshot / Chunk::editableBlocks: a snapshot is
+// a reference, the first write after it pays for one storage copy.
+template<typename Fn>
+bool reportSnapshotCost(const std::string& name, Fn blockAt) {
+    auto live = std::make_shared<ChunkBlockStorage>(makeStorage(blockAt));
+    constexpr int rounds = 10000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        std::shared_ptr<const ChunkBlockStorage> snapshot = live;
+        volatile int bits = snapshot->getBitsPerEntry();
+        (void)bits;
+    }
+    double snapshotNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+    start = std::chrono::high_resolution_clock::now();
+    bool intact = true;
+    for (int r = 0; r < rounds; ++r) {
+        std::shared_ptr<const ChunkBlockStorage> snapshot = live;
+        const Blocks before = snapshot->get(0);
+        if (live.use_count() > 1) live = std::make_shared<ChunkBlockStorage>(*live);
+        live->set(0, before == Blocks::Stone ? Blocks::Dirt : Blocks::Stone);
+        intact = intact && snapshot->get(0) == before;
+    }
+    double cowNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+    std::cout << "[snapshot " << name << "] take " << snapshotNs << " ns, first write after it "
+              << cowNs / 1000.0 << " us (" << live->getMemoryUsage() << " bytes copied), snapshot "
+              << (intact ? "unchanged" : "MODIFIED") << "\n";
+    return intact;
+}
+
+// The old generate/load path: a vector of (pos, id) pairs fed to Chunk::setBlocks, which did
+// set() + a version bump + setOpaque() per voxel and, for border voxels, looked the
+// neighbour chunks up under the container lock. Against ChunkBlockStorage::assign plus
+// one opacity pass per row as TerrainGenerator and Chunk::assignBlocks now do.
+void reportBulkConstruction() {
+    std::vector<Blocks> palette;
+    std::vector<uint16_t> indices(ChunkBlockStorage::VOLUME);
+    for (int z = 0; z < S; ++z)
+    for (int y = 0; y < S; ++y)
+    for (int x = 0; x < S; ++x) {
+        Blocks id = terrainBlock(x, y, z);
+        auto it = std::find(palette.begin(), palette.end(), id);
+        if (it == palette.end()) it = palette.insert(palette.end(), id);
+        indices[ChunkBlockStorage::toIndex(x, y, z)] = static_cast<uint16_t>(it - palette.begin());
+    }
+    auto opaque = [](Blocks id) { return id != Blocks::Air; };
+
+    std::shared_mutex containerMutex;
+    std::unordered_map<int, int> loadedChunks;
+    for (int i = 0; i < 1331; ++i) loadedChunks[i] = i;
+    std::atomic<uint64_t> version{0};
+
+    constexpr int rounds = 200;
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        ChunkBlockStorage storage;
+        ChunkBlocksOpaqueData opacity;
+        std::vector<std::pair<glm::ivec3, Blocks>> changes;
+        for (int x = 0; x < S; ++x)
+        for (int z = 0; z < S; ++z)
+        for (int y = 0; y < S; ++y) {
+            changes.emplace_back(glm::ivec3(x, y, z), palette[indices[ChunkBlockStorage::toIndex(x, y, z)]]);
+        }
+        for (const auto& [pos, id] : changes) {
+            storage.set(ChunkBlockStorage::toIndex(pos.x, pos.y, pos.z), id);
+            version.fetch_add(1);
+            opacity.setOpaque(pos.x, pos.y, pos.z, opaque(id));
+            const int borders = (pos.x == 0) + (pos.x == S - 1) + (pos.y == 0) + (pos.y == S - 1) + (pos.z == 0) + (pos.z == S - 1);
+            for (int b = 0; b < borders; ++b) {
+                std::shared_lock lock(containerMutex);
+                checksum += loadedChunks.find((pos.x * 7 + pos.z + b) % 1331)->second;
+            }
+        }
+        checksum += opacity.getRow(3, 3);
+    }
+    double perVoxelUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        ChunkBlockStorage storage;
+        ChunkBlocksOpaqueData opacity;
+        storage.assign(palette, indices);
+        std::vector<uint32_t> paletteOpaque;
+        for (Blocks id : storage.getPalette()) paletteOpaque.push_back(opaque(id) ? 1u : 0u);
+        for (int z = 0; z < S; ++z)
+        for (int y = 0; y < S; ++y) {
+            uint32_t row = 0;
+            int rowStart = ChunkBlockStorage::toIndex(0, y, z);
+            for (int x = 0; x < S; ++x) row |= paletteOpaque[storage.getPaletteIndex(rowStart + x)] << x;
+            opacity.setRow(y, z, row);
+        }
+        checksum += opacity.getRow(3, 3);
+    }
+    double bulkUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / rounds;
+
+    volatile uint64_t sink = checksum;
+    (void)sink;
+    std::cout << "[bulk construction] per voxel " << perVoxelUs << " us/chunk, bulk " << bulkUs
+              << " us/chunk (" << perVoxelUs / bulkUs << "x)\n";
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    reportAirCube();
+    ok = reportUniformTransitions() && ok;
+    ok = report("all air", [](int, int, int) { return Blocks::Air; }) && ok;
+    ok = report("surface terrain", terrainBlock) && ok;
+    ok = report("all types mixed", noisyBlock) && ok;
+    reportBulkConstruction();
+    ok = reportSnapshotCost("all air", [](int, int, int) { return Blocks::Air; }) && ok;
+    ok = reportSnapshotCost("surface terrain", terrainBlock) && ok;
+    ok = reportSnapshotCost("all types mixed", noisyBlock) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ChunkUploadScheduler.h"
+
+// Offers meshes to the per-frame budget of ChunkUploadScheduler on a simulated clock,
+// each upload taking as long as the rate the budget was taught. No GL context: the
+// scheduler itself only adds the GL calls and the upload order around ChunkUploadBudget.
+
+namespace {
+
+using Clock = ChunkUploadBudget::Clock;
+
+constexpr uint64_t MB = 1024 * 1024;
+
+struct Mesh {
+    uint64_t bytes;
+    bool urgent;
+};
+
+struct Frame {
+    size_t uploads = 0;
+    uint64_t bytes = 0;
+    std::chrono::nanoseconds took{0};
+};
+
+ChunkUploadBudget makeBudget() {
+    return ChunkUploadBudget(ChunkUploadScheduler::FRAME_BYTE_BUDGET, ChunkUploadScheduler::FRAME_TIME_BUDGET);
+}
+
+// Uploads at nanosPerByte until the first mesh the budget turns down, after a stall
+// (waiting for a staging segment) at the start of the frame
+Frame runFrame(ChunkUploadBudget& budget, const std::vector<Mesh>& meshes, double nanosPerByte,
+               std::chrono::nanoseconds stall = std::chrono::nanoseconds(0)) {
+    const Clock::time_point start{};
+    Clock::time_point now = start + stall;
+    budget.beginFrame(start);
+    for (const Mesh& mesh : meshes) {
+        if (!budget.admits(mesh.bytes, mesh.urgent, now)) break;
+        const auto took = std::chrono::nanoseconds(static_cast<int64_t>(mesh.bytes * nanosPerByte));
+        now += took;
+        budget.record(mesh.bytes, static_cast<double>(took.count()));
+    }
+    return Frame{ budget.getUploads(), budget.getBytes(), now - start };
+}
+
+// Rate learned from earlier frames of large uploads
+void teach(ChunkUploadBudget& budget, double nanosPerByte) {
+    for (int i = 0; i < 100; ++i) runFrame(budget, { { MB, false } }, nanosPerByte);
+}
+
+bool check(const std::string& name, bool ok, const Frame& frame) {
+    std::cout << "[" << name << "] " << frame.uploads << " uploads, " << frame.bytes / 1024 << " KB in "
+              << frame.took.count() / 1000 << " us, " << (ok ? "ok" : "WRONG") << "\n";
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    const auto timeBudget = std::chrono::duration_cast<std::chrono::nanoseconds>(ChunkUploadScheduler::FRAME_TIME_BUDGET);
+    const uint64_t byteBudget = ChunkUploadScheduler::FRAME_BYTE_BUDGET;
+    bool ok = true;
+
+    // Fast uploads (10 GB/s): the byte budget stops the frame
+    {
+        ChunkUploadBudget budget = makeBudget();
+        teach(budget, 0.1);
+        const Frame frame = runFrame(budget, std::vector<Mesh>(20, { MB, false }), 0.1);
+        ok = check("byte budget", frame.bytes == byteBudget && frame.uploads == byteBudget / MB, frame) && ok;
+    }
+
+    // Slow uploads (1 GB/s, the starting guess): the time budget stops the frame before
+    // the upload that would go over it, not after
+    {
+        ChunkUploadBudget budget = makeBudget();
+        teach(budget, 1.0);
+        const Frame frame = runFrame(budget, std::vector<Mesh>(20, { 256 * 1024, false }), 1.0);
+        const auto perMesh = std::chrono::nanoseconds(256 * 1024);
+        ok = check("time budget", frame.took <= timeBudget && frame.took + perMesh > timeBudget, frame) && ok;
+    }
+
+    // A frame stalled past its time budget uploads nothing but edits
+    {
+        ChunkUploadBudget budget = makeBudget();
+        const Frame frame = runFrame(budget, { { 64 * 1024, true }, { 64 * 1024, true }, { 64 * 1024, false } },
+                                     1.0, timeBudget + std::chrono::microseconds(500));
+        ok = check("stalled frame", frame.uploads == 2, frame) && ok;
+    }
+
+    // Edits go whatever the budgets say, and count: after 12 MB of them nothing else fits
+    {
+        ChunkUploadBudget budget = makeBudget();
+        teach(budget, 0.1);
+        std::vector<Mesh> meshes(6, { 2 * MB, true });
+        meshes.insert(meshes.end(), 4, { MB, false });
+        const Frame frame = runFrame(budget, meshes, 0.1);
+        ok = check("urgent over budget", frame.uploads == 6, frame) && ok;
+    }
+
+    // A mesh larger than the byte budget goes alone, first in its frame
+    {
+        ChunkUploadBudget budget = makeBudget();
+        teach(budget, 0.1);
+        const Frame first = runFrame(budget, { { byteBudget + MB, false }, { 16 * 1024, false } }, 0.1);
+        const Frame second = runFrame(budget, { { 16 * 1024, false } }, 0.1);
+        ok = check("oversized mesh", first.uploads == 1 && first.bytes == byteBudget + MB && second.uploads == 1, first) && ok;
+    }
+
+    // Small meshes leave the measured rate alone
+    {
+        ChunkUploadBudget budget = makeBudget();
+        teach(budget, 0.5);
+        const double learned = budget.getNanosPerByte();
+        runFrame(budget, std::vector<Mesh>(50, { 4 * 1024, false }), 20.0);
+        const bool kept = budget.getNanosPerByte() == learned && learned > 0.45 && learned < 0.55;
+        std::cout << "[small meshes] rate " << learned << " ns/B, " << (kept ? "kept" : "CHANGED") << "\n";
+        ok = kept && ok;
+    }
+
+    return ok ? 0 : 1;
+}
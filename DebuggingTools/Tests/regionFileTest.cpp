@@ -0,0 +1,218 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "RegionFile.h"
+
+// Saves and loads 10k chunks as one file per chunk (the old layout) and as
+// region files, checks that rewrites reuse freed sectors and measures synced
+// (checkpoint) rewrites. Then fills one region with a few repeated payloads to
+// check that identical chunks share sectors.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr int CHUNKS = 10000;
+
+// Sizes of the v1 chunk format: 1 byte for an air chunk, about 140 KB for a
+// surface chunk. With view distance 5 one chunk layer in 11 has terrain.
+std::string payloadFor(int i) {
+    if (i % 11 != 0) return std::string(1, '\0');
+    std::string bytes(140 * 1024, '\0');
+    for (size_t b = 0; b < bytes.size(); b += 64) bytes[b] = static_cast<char>(i + b);
+    return bytes;
+}
+
+ChunkPos chunkAt(int i) {
+    // 22 x 22 x 21 block of chunks around the origin, spans several regions
+    return ChunkPos(i % 22 - 11, (i / 22) % 22 - 11, i / (22 * 22) - 10);
+}
+
+template<typename Fn>
+double seconds(Fn fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void report(const std::string& name, double saveSeconds, double loadSeconds, size_t bytes, size_t files) {
+    std::cout << "[" << name << "] save " << static_cast<int>(CHUNKS / saveSeconds) << " chunks/s, load "
+              << static_cast<int>(CHUNKS / loadSeconds) << " chunks/s, " << files << " files, "
+              << bytes / (1024 * 1024) << " MB on disk\n";
+}
+
+size_t directoryBytes(const fs::path& dir, size_t& files) {
+    size_t bytes = 0;
+    files = 0;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        bytes += entry.file_size();
+        ++files;
+    }
+    return bytes;
+}
+
+// Uniform and flat chunks repeat byte for byte: 4 distinct payloads over a whole region.
+// Rewrites and erases must leave the chunks still sharing a sector intact, also after a reopen.
+bool reportDedup(const fs::path& root) {
+    const fs::path path = root / "Region_dedup";
+    auto local = [](int i) { return ChunkPos(i % 16, (i / 16) % 16, i / 256); };
+
+    std::vector<std::string> variants;
+    for (int v = 0; v < 4; ++v) {
+        variants.emplace_back(v == 0 ? 14 : 2000 + v * 100, static_cast<char>('a' + v));
+    }
+
+    std::vector<std::string> expected(RegionFile::CHUNK_COUNT);
+    RegionFileStats written;
+    {
+        RegionFile region(path);
+        for (int i = 0; i < RegionFile::CHUNK_COUNT; ++i) {
+            expected[i] = variants[i % variants.size()];
+            region.write(local(i), expected[i].data(), expected[i].size());
+        }
+        written = region.getStats();
+
+        // Every other chunk gets a payload of its own, every third is erased
+        for (int i = 0; i < RegionFile::CHUNK_COUNT; i += 2) {
+            expected[i] = std::string(100, static_cast<char>(i)) + std::to_string(i);
+            region.write(local(i), expected[i].data(), expected[i].size());
+        }
+        for (int i = 0; i < RegionFile::CHUNK_COUNT; i += 3) {
+            expected[i].clear();
+            region.erase(local(i));
+        }
+    }
+
+    RegionFile reopened(path);
+    for (int i = 1; i < RegionFile::CHUNK_COUNT; i += 6) {
+        expected[i] = variants[1];
+        reopened.write(local(i), expected[i].data(), expected[i].size());
+    }
+    bool same = true;
+    for (int i = 0; i < RegionFile::CHUNK_COUNT; ++i) {
+        bool found = reopened.read(local(i), [&](const char* data, size_t size) {
+            same = same && std::string(data, size) == expected[i];
+        });
+        same = same && found == !expected[i].empty();
+    }
+
+    std::cout << "[dedup] " << RegionFile::CHUNK_COUNT << " chunks of " << variants.size() << " payloads: "
+              << written.usedSectors << " sectors in use, " << written.sharedChunks << " chunks shared"
+              << ", after rewrites and reopen " << reopened.getStats().usedSectors << " sectors, contents "
+              << (same ? "match" : "DIFFER") << "\n";
+    return same;
+}
+
+} // namespace
+
+int main() {
+    const fs::path root = fs::temp_directory_path() / "mineox_region_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "chunks");
+    fs::create_directories(root / "regions");
+
+    std::vector<std::string> payloads(CHUNKS);
+    for (int i = 0; i < CHUNKS; ++i) payloads[i] = payloadFor(i);
+
+    // One file per chunk, exists check + open per load like ChunkMemoryContainer did
+    size_t checksum = 0;
+    double fileSave = seconds([&] {
+        for (int i = 0; i < CHUNKS; ++i) {
+            std::ofstream ofs(root / "chunks" / chunkAt(i).toString(), std::ios::binary | std::ios::trunc);
+            ofs.write(payloads[i].data(), payloads[i].size());
+        }
+    });
+    double fileLoad = seconds([&] {
+        for (int i = 0; i < CHUNKS; ++i) {
+            fs::path path = root / "chunks" / chunkAt(i).toString();
+            if (!fs::exists(path)) continue;
+            std::ifstream ifs(path, std::ios::binary);
+            std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+            checksum += bytes.size();
+        }
+    });
+    size_t files = 0;
+    size_t fileBytes = directoryBytes(root / "chunks", files);
+    report("file per chunk", fileSave, fileLoad, fileBytes, files);
+
+    // Region files, kept open the way RegionStorage does
+    std::vector<std::unique_ptr<RegionFile>> regions;
+    auto regionFor = [&](const ChunkPos& pos) -> RegionFile& {
+        glm::ivec3 r = RegionFile::toRegionPos(pos);
+        int slot = (r.x + 1) + 3 * ((r.y + 1) + 3 * (r.z + 1));
+        if (regions.size() < 27) regions.resize(27);
+        if (!regions[slot]) {
+            regions[slot] = std::make_unique<RegionFile>(root / "regions" /
+                ("Region_" + std::to_string(r.x) + "_" + std::to_string(r.y) + "_" + std::to_string(r.z)));
+        }
+        return *regions[slot];
+    };
+
+    size_t regionChecksum = 0;
+    bool same = true;
+    double regionSave = seconds([&] {
+        for (int i = 0; i < CHUNKS; ++i) {
+            regionFor(chunkAt(i)).write(chunkAt(i), payloads[i].data(), payloads[i].size());
+        }
+    });
+    double regionLoad = seconds([&] {
+        for (int i = 0; i < CHUNKS; ++i) {
+            regionFor(chunkAt(i)).read(chunkAt(i), [&](const char* data, size_t size) {
+                regionChecksum += size;
+                same = same && size == payloads[i].size() && std::equal(data, data + size, payloads[i].begin());
+            });
+        }
+    });
+    size_t regionFiles = 0;
+    size_t regionBytes = directoryBytes(root / "regions", regionFiles);
+    report("region files", regionSave, regionLoad, regionBytes, regionFiles);
+    bool ok = same && checksum == regionChecksum;
+    std::cout << "  contents " << (ok ? "match" : "DIFFER") << "\n";
+
+    // Rewrite every surface chunk: new data goes to free sectors, old sectors are reused
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int i = 0; i < CHUNKS; i += 11) {
+            regionFor(chunkAt(i)).write(chunkAt(i), payloads[i].data(), payloads[i].size());
+        }
+    }
+    size_t used = 0;
+    size_t total = 0;
+    for (const auto& region : regions) {
+        if (!region) continue;
+        auto stats = region->getStats();
+        used += stats.usedSectors;
+        total += stats.fileSectors;
+    }
+    size_t rewrittenFiles = 0;
+    size_t rewrittenBytes = directoryBytes(root / "regions", rewrittenFiles);
+    std::cout << "[rewrite x3] " << rewrittenBytes / (1024 * 1024) << " MB on disk (was " << regionBytes / (1024 * 1024)
+              << " MB), " << used << " of " << total << " sectors in use\n";
+
+    // Checkpoint writes: every surface chunk again, synced before and after its table entry
+    const int durableChunks = (CHUNKS + 10) / 11;
+    double durableSave = seconds([&] {
+        for (int i = 0; i < CHUNKS; i += 11) {
+            regionFor(chunkAt(i)).write(chunkAt(i), payloads[i].data(), payloads[i].size(), true);
+        }
+    });
+    bool durableSame = true;
+    for (int i = 0; i < CHUNKS; i += 11) {
+        regionFor(chunkAt(i)).read(chunkAt(i), [&](const char* data, size_t size) {
+            durableSame = durableSame && size == payloads[i].size() && std::equal(data, data + size, payloads[i].begin());
+        });
+    }
+    std::cout << "[durable rewrite] " << static_cast<int>(durableChunks / durableSave) << " chunks/s, contents "
+              << (durableSame ? "match" : "DIFFER") << "\n";
+    ok = durableSame && ok;
+
+    regions.clear();
+    ok = reportDedup(root) && ok;
+    fs::remove_all(root);
+    return ok ? 0 : 1;
+}
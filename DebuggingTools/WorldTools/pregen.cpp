@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <exception>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "ChunkDataAccess.h"
+#include "ChunkGeneratorRegistry.h"
+#include "PathProvider.h"
+#include "RegionFile.h"
+#include "RegionStorage.h"
+#include "TerrainGenerator.h"
+#include "WorldInfo.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// mineox-pregen: headless world pre-generation. Fills a box or a sphere of chunks with
+// the world's generator on all cores and stores each one as a full payload, so the
+// game loads them instead of generating them while the player moves. Chunks already
+// stored are skipped: an interrupted run (Ctrl+C stops cleanly) resumes where it left off.
+// Also the generator benchmark: --no-store only generates and encodes.
+//
+// Generated chunks are normally never saved (only changes over the terrain are), so a
+// pregenerated area keeps the terrain of the generator version that wrote it and takes
+// disk space; worldAnalyzer --prune-generated takes it back.
+//
+// pregen <world name> [options]
+//   --seed N            seed of a new world, default WorldInfo::DEFAULT_SEED; an existing
+//                       world always generates with the seed in its world.info
+//   --from X Y Z --to X Y Z   chunk box, both corners included
+//   --radius R          chunks within R chunks of --center instead of a box
+//   --center X Y Z      default 0 0 0
+//   --threads N         default: all cores
+//   --compress          deflate stored payloads
+//   --no-store          generate and encode only, nothing is written
+
+namespace {
+
+std::atomic<bool> stopRequested{false};
+
+struct Options {
+    std::string worldName;
+    bool seedGiven = false;
+    int seed = WorldInfo::DEFAULT_SEED;
+    bool box = false;
+    glm::ivec3 from{ 0 };
+    glm::ivec3 to{ 0 };
+    int radius = -1;
+    glm::ivec3 center{ 0 };
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool compress = false;
+    bool store = true;
+};
+
+struct Region {
+    glm::ivec3 regionPos;
+    std::vector<ChunkPos> chunks;
+    int distance = 0;
+};
+
+// Whole argument as a decimal int, false for anything else (no exception reaches main)
+bool parseInt(const char* text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return text[used] == '\0';
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    if (argc < 2) return false;
+    options.worldName = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&](int& value) {
+            return i + 1 < argc && parseInt(argv[++i], value);
+        };
+        auto nextVec = [&](glm::ivec3& value) { return next(value.x) && next(value.y) && next(value.z); };
+        int value = 0;
+        if (arg == "--seed" && next(options.seed)) options.seedGiven = true;
+        else if (arg == "--from" && nextVec(options.from)) options.box = true;
+        else if (arg == "--to" && nextVec(options.to)) options.box = true;
+        else if (arg == "--radius" && next(options.radius)) {}
+        else if (arg == "--center" && nextVec(options.center)) {}
+        else if (arg == "--threads" && next(value)) options.threads = std::max(1, value);
+        else if (arg == "--compress") options.compress = true;
+        else if (arg == "--no-store") options.store = false;
+        else return false;
+    }
+    return options.box != (options.radius >= 0);
+}
+
+// Grouped by region, nearest region first, so a partial run leaves a usable area
+std::vector<Region> collectRegions(const Options& options) {
+    glm::ivec3 lo = options.box ? glm::min(options.from, options.to) : options.center - options.radius;
+    glm::ivec3 hi = options.box ? glm::max(options.from, options.to) : options.center + options.radius;
+    const glm::ivec3 mid = options.box ? (lo + hi) / 2 : options.center;
+
+    std::map<std::tuple<int, int, int>, Region> byRegion;
+    for (int x = lo.x; x <= hi.x; ++x) {
+        for (int y = lo.y; y <= hi.y; ++y) {
+            for (int z = lo.z; z <= hi.z; ++z) {
+                const glm::ivec3 offset = glm::ivec3(x, y, z) - options.center;
+                if (!options.box && offset.x * offset.x + offset.y * offset.y + offset.z * offset.z >
+                                    options.radius * options.radius) continue;
+                const ChunkPos pos(x, y, z);
+                const glm::ivec3 r = RegionFile::toRegionPos(pos);
+                Region& region = byRegion[{ r.x, r.y, r.z }];
+                region.regionPos = r;
+                region.chunks.push_back(pos);
+            }
+        }
+    }
+
+    std::vector<Region> regions;
+    for (auto& [key, region] : byRegion) {
+        const glm::ivec3 d = region.regionPos * RegionFile::REGION_SIZE + RegionFile::REGION_SIZE / 2 - mid;
+        region.distance = d.x * d.x + d.y * d.y + d.z * d.z;
+        regions.push_back(std::move(region));
+    }
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.distance < b.distance; });
+    return regions;
+}
+
+uint64_t directoryBytes(const fs::path& dir) {
+    uint64_t bytes = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        bytes += entry.is_regular_file(ec) ? entry.file_size(ec) : 0;
+    }
+    return bytes;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: pregen <world name> (--from X Y Z --to X Y Z | --radius R [--center X Y Z])\n"
+                     "       [--seed N] [--threads N] [--compress] [--no-store]\n";
+        return 2;
+    }
+    // Stored chunks are only loaded over the terrain of the world's own seed
+    if (auto info = WorldInfo::load(options.worldName)) {
+        if (options.seedGiven && info->seed != options.seed) {
+            std::cerr << "world '" << options.worldName << "' was created with seed " << info->seed
+                      << ", not " << options.seed << "\n";
+            return 2;
+        }
+        options.seed = info->seed;
+    } else if (options.store) {
+        WorldInfo::loadOrCreate(options.worldName, options.seed);
+    }
+    std::signal(SIGINT, [](int) { stopRequested = true; });
+
+    auto& storage = RegionStorage::getInstance();
+    auto& generators = ChunkGeneratorRegistry::getInstance();
+    generators.set(options.worldName, std::make_shared<TerrainGenerator>(options.seed));
+    ChunkDataAccess::setCompression(options.compress);
+    if (options.store) {
+        std::error_code ec;
+        fs::create_directories(PathProvider::getInstance().getWorldRegionsPath(options.worldName), ec);
+        storage.openWorld(options.worldName);
+    }
+
+    std::vector<Region> regions = collectRegions(options);
+    size_t total = 0;
+    for (const auto& region : regions) total += region.chunks.size();
+
+    std::atomic<size_t> done{0};
+    std::atomic<size_t> generated{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<uint64_t> generateNanos{0};
+    std::atomic<size_t> nextRegion{0};
+
+    auto worker = [&] {
+        ChunkDataAccess dataAccess;
+        auto generator = generators.find(options.worldName);
+        for (size_t r = nextRegion++; r < regions.size() && !stopRequested; r = nextRegion++) {
+            for (const auto& pos : regions[r].chunks) {
+                if (stopRequested) break;
+                if (options.store && storage.contains(options.worldName, pos)) {
+                    ++done;
+                    continue;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                ChunkSnapshot snapshot;
+                snapshot.pos = pos;
+                snapshot.blocks = generator->generateChunk(pos);
+                generateNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+
+                // In full: the diff against its own terrain would be empty and not stored at all
+                const std::string bytes = dataAccess.serialize(snapshot);
+                if (options.store && !storage.write(options.worldName, pos, bytes)) ++failed;
+                ++generated;
+                ++done;
+            }
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < options.threads; ++t) workers.emplace_back(worker);
+
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    while (done < total && !stopRequested) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const double seconds = elapsed();
+        const double rate = generated / std::max(seconds, 1e-6);
+        std::cout << "\r" << done << " / " << total << " chunks, " << static_cast<int>(rate) << " chunks/s"
+                  << ", eta " << static_cast<int>(rate > 0 ? (total - done) / rate : 0) << " s   " << std::flush;
+    }
+    for (auto& thread : workers) thread.join();
+    const double seconds = elapsed();
+
+    if (options.store) storage.closeAll();
+
+    std::cout << "\r" << done << " / " << total << " chunks" << (stopRequested ? ", stopped: run again to resume" : "")
+              << "\ngenerated " << generated << " in " << seconds << " s, "
+              << static_cast<int>(generated / std::max(seconds, 1e-6)) << " chunks/s on " << options.threads
+              << " threads, generator " << (generated == 0 ? 0 : generateNanos / generated / 1000) << " us per chunk\n";
+    if (options.store) {
+        std::cout << "regions on disk: "
+                  << directoryBytes(PathProvider::getInstance().getWorldRegionsPath(options.worldName)) / 1024
+                  << " KB" << (failed > 0 ? ", " + std::to_string(failed.load()) + " chunks failed to store" : "")
+                  << "\n";
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "ChunkDataAccess.h"
+#include "ChunkGeneratorRegistry.h"
+#include "PathProvider.h"
+#include "RegionFile.h"
+#include "RegionStorage.h"
+#include "TerrainGenerator.h"
+#include "WorldInfo.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Headless world analyzer and pruner. Scans every chunk saved in a world's region
+// files on all cores and reports block histograms, the share of all-air, uniform and
+// player-modified chunks, and region file sizes. Optionally deletes chunks that
+// match their regenerated terrain or lie outside a radius, and compacts region files.
+// Reads and writes through PathProvider, RegionStorage and ChunkDataAccess, the same
+// code the game uses. Run it while the game is closed.
+//
+// worldAnalyzer <world name> [options]
+//   --threads N         worker threads, default: all cores
+//   --seed N            generator seed, default: the world's world.info, else the first
+//                       chunk saved as changes
+//   --prune-generated   delete chunks identical to their regenerated terrain
+//   --radius R          delete chunks further than R chunks from --center (per axis)
+//   --center X Y Z      chunk position the radius is measured from, default 0 0 0
+//   --compact           rewrite every region file packed, payloads in the smallest current format
+//   --compress          deflate payloads rewritten by --compact
+//   --dry-run           report what would be deleted or compacted, change nothing
+
+namespace {
+
+struct Options {
+    std::string worldName;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool seedGiven = false;
+    int seed = WorldInfo::DEFAULT_SEED;
+    bool pruneGenerated = false;
+    int radius = -1;
+    glm::ivec3 center{ 0 };
+    bool compact = false;
+    bool compress = false;
+    bool dryRun = false;
+};
+
+struct Totals {
+    size_t chunks = 0;
+    uint64_t payloadBytes = 0;
+    size_t airChunks = 0;
+    size_t uniformChunks = 0;
+    size_t modifiedChunks = 0;   // stored as changes over generated terrain
+    size_t fullChunks = 0;       // stored in full
+    size_t generatedChunks = 0;  // identical to regenerated terrain, nothing worth keeping
+    size_t outsideRadius = 0;
+    size_t corrupt = 0;
+    size_t deleted = 0;
+    std::array<uint64_t, static_cast<size_t>(Blocks::Count)> blocks{};
+
+    void add(const Totals& other) {
+        chunks += other.chunks;
+        payloadBytes += other.payloadBytes;
+        airChunks += other.airChunks;
+        uniformChunks += other.uniformChunks;
+        modifiedChunks += other.modifiedChunks;
+        fullChunks += other.fullChunks;
+        generatedChunks += other.generatedChunks;
+        outsideRadius += other.outsideRadius;
+        corrupt += other.corrupt;
+        deleted += other.deleted;
+        for (size_t i = 0; i < blocks.size(); ++i) blocks[i] += other.blocks[i];
+    }
+};
+
+struct Region {
+    glm::ivec3 regionPos;
+    std::vector<ChunkPos> chunks;
+    uint64_t payloadBytes = 0;
+    uint64_t fileBytes = 0;
+    uint64_t compactedBytes = 0;
+    size_t droppedChunks = 0;  // unreadable, left out of the compacted file
+};
+
+// Whole argument as a decimal int, false for anything else (no exception reaches main)
+bool parseInt(const char* text, int& value) {
+    try {
+        size_t used = 0;
+        value = std::stoi(text, &used);
+        return text[used] == '\0';
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    if (argc < 2) return false;
+    options.worldName = argv[1];
+    for (int i = 2; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&](int& value) {
+            return i + 1 < argc && parseInt(argv[++i], value);
+        };
+        int value = 0;
+        if (arg == "--threads" && next(value)) options.threads = std::max(1, value);
+        else if (arg == "--seed" && next(options.seed)) options.seedGiven = true;
+        else if (arg == "--prune-generated") options.pruneGenerated = true;
+        else if (arg == "--radius" && next(options.radius)) {}
+        else if (arg == "--center" && next(options.center.x) && next(options.center.y) && next(options.center.z)) {}
+        else if (arg == "--compact") options.compact = true;
+        else if (arg == "--compress") options.compress = true;
+        else if (arg == "--dry-run") options.dryRun = true;
+        else return false;
+    }
+    return true;
+}
+
+bool isDiffPayload(const char* data, size_t size) {
+    uint32_t version = 0;
+    if (size < sizeof(version) || data[0] == 0) return false;
+    std::memcpy(&version, data, sizeof(version));
+    return version == ChunkCodec::VERSION_DIFF;
+}
+
+// Chunks saved as changes carry the seed of the world that wrote them
+bool findSeed(const std::string& worldName, const std::vector<ChunkPos>& chunks, int& seed) {
+    constexpr size_t MAX_PROBES = 256;
+    auto& regions = RegionStorage::getInstance();
+    for (size_t i = 0; i < chunks.size() && i < MAX_PROBES; ++i) {
+        const ChunkPos& pos = chunks[i];
+        DecodedChunk decoded;
+        bool isDiff = false;
+        regions.read(worldName, pos, [&](const char* data, size_t size) {
+            isDiff = isDiffPayload(data, size) && ChunkCodec::decode(data, size, decoded);
+        });
+        if (isDiff) {
+            seed = static_cast<int>(decoded.seed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool outside(const Options& options, const ChunkPos& pos) {
+    if (options.radius < 0) return false;
+    const glm::ivec3 offset = glm::abs(pos.position - options.center);
+    return std::max({ offset.x, offset.y, offset.z }) > options.radius;
+}
+
+void scanRegion(const Options& options, Region& region, Totals& totals) {
+    auto& regions = RegionStorage::getInstance();
+    ChunkDataAccess dataAccess;
+
+    for (const auto& pos : region.chunks) {
+        ++totals.chunks;
+
+        ChunkSnapshot snapshot;
+        bool decoded = false;
+        bool isDiff = false;
+        regions.read(options.worldName, pos, [&](const char* data, size_t size) {
+            region.payloadBytes += size;
+            isDiff = isDiffPayload(data, size);
+            decoded = dataAccess.decodeSnapshot(pos, data, size, options.worldName, snapshot);
+        });
+        if (!decoded) {
+            ++totals.corrupt;
+            continue;
+        }
+
+        const ChunkBlockStorage& blocks = *snapshot.blocks;
+        const auto& palette = blocks.getPalette();
+        const auto& refs = blocks.getPaletteRefs();
+        for (size_t entry = 0; entry < palette.size(); ++entry) {
+            totals.blocks[static_cast<size_t>(palette[entry])] += refs[entry];
+        }
+        if (blocks.isUniform()) {
+            ++(blocks.getUniformBlock() == Blocks::Air ? totals.airChunks : totals.uniformChunks);
+        }
+        ++(isDiff ? totals.modifiedChunks : totals.fullChunks);
+
+        // Empty when saving it again would find nothing over the generated terrain
+        const bool generated = dataAccess.serialize(snapshot, options.worldName).empty();
+        const bool far = outside(options, pos);
+        totals.generatedChunks += generated ? 1 : 0;
+        totals.outsideRadius += far ? 1 : 0;
+
+        if ((generated && options.pruneGenerated) || far) {
+            if (options.dryRun || regions.erase(options.worldName, pos)) ++totals.deleted;
+        }
+    }
+    totals.payloadBytes += region.payloadBytes;
+}
+
+// Copies the region's remaining chunks into a fresh file, each in its smallest current
+// encoding, and swaps it in. Freed sectors and grown tails of the old file are gone, and
+// so are chunks whose payload cannot be read; the swap takes them out of the chunk index.
+bool compactRegion(const Options& options, Region& region) {
+    const fs::path path = PathProvider::getInstance().getRegionFilePath(options.worldName, region.regionPos);
+    fs::path packedPath = path;
+    packedPath += ".compact";
+
+    auto& storage = RegionStorage::getInstance();
+    std::error_code ec;
+    if (region.chunks.empty()) {
+        return options.dryRun || storage.removeRegion(options.worldName, region.regionPos);
+    }
+
+    ChunkDataAccess dataAccess;
+    bool ok = true;
+    size_t usedEnd = 0;
+    {
+        RegionFile source(path);
+        RegionFile packed(packedPath);
+        if (!source.isOpen() || !packed.isOpen()) return false;
+
+        for (const auto& pos : region.chunks) {
+            std::string bytes;
+            source.read(pos, [&](const char* data, size_t size) {
+                bytes.assign(data, size);
+                ChunkSnapshot snapshot;
+                if (!dataAccess.decodeSnapshot(pos, data, size, options.worldName, snapshot)) return;
+                std::string smallest = dataAccess.serialize(snapshot, options.worldName);
+                if (!smallest.empty() && smallest.size() < bytes.size()) bytes = std::move(smallest);
+            });
+            if (bytes.empty()) {
+                ++region.droppedChunks;
+                continue;
+            }
+            ok = ok && packed.write(pos, bytes.data(), bytes.size());
+        }
+        usedEnd = packed.getStats().usedEnd;
+    }
+
+    // Writes grow the file ahead of need, cut it after the last payload
+    fs::resize_file(packedPath, usedEnd * RegionFile::SECTOR_SIZE, ec);
+    region.compactedBytes = fs::file_size(packedPath, ec);
+    if (!ok || options.dryRun) {
+        fs::remove(packedPath, ec);
+        return ok;
+    }
+    if (!storage.replaceRegion(options.worldName, region.regionPos, packedPath)) {
+        fs::remove(packedPath, ec);
+        return false;
+    }
+    return true;
+}
+
+template<typename Fn>
+void forEachRegionParallel(unsigned threads, std::vector<Region>& regions, Fn&& fn) {
+    std::atomic<size_t> nextRegion{0};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t r = nextRegion++; r < regions.size(); r = nextRegion++) {
+                fn(t, regions[r]);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+std::string percent(size_t part, size_t whole) {
+    return std::to_string(whole == 0 ? 0 : part * 100 / whole) + "%";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "usage: worldAnalyzer <world name> [--threads N] [--seed N] [--prune-generated]\n"
+                     "       [--radius R] [--center X Y Z] [--compact] [--compress] [--dry-run]\n";
+        return 2;
+    }
+
+    auto& storage = RegionStorage::getInstance();
+    const fs::path regionsPath = PathProvider::getInstance().getWorldRegionsPath(options.worldName);
+    if (!fs::exists(regionsPath)) {
+        std::cerr << "no regions at " << regionsPath.string() << "\n";
+        return 1;
+    }
+    storage.openWorld(options.worldName);
+
+    std::vector<ChunkPos> chunks = storage.listChunks(options.worldName);
+    if (!options.seedGiven) {
+        if (auto info = WorldInfo::load(options.worldName)) {
+            options.seed = info->seed;
+        } else if (!findSeed(options.worldName, chunks, options.seed)) {
+            std::cout << "no world.info and no chunk saved as changes, assuming seed " << options.seed << "\n";
+        }
+    }
+    ChunkGeneratorRegistry::getInstance().set(options.worldName, std::make_shared<TerrainGenerator>(options.seed));
+    ChunkDataAccess::setCompression(options.compress);
+
+    std::map<std::tuple<int, int, int>, Region> byRegion;
+    for (const auto& pos : chunks) {
+        const glm::ivec3 r = RegionFile::toRegionPos(pos);
+        Region& region = byRegion[{ r.x, r.y, r.z }];
+        region.regionPos = r;
+        region.chunks.push_back(pos);
+    }
+    std::vector<Region> regions;
+    for (auto& [key, region] : byRegion) regions.push_back(std::move(region));
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Totals> perThread(options.threads);
+    forEachRegionParallel(options.threads, regions, [&](unsigned thread, Region& region) {
+        scanRegion(options, region, perThread[thread]);
+    });
+    Totals totals;
+    for (const auto& t : perThread) totals.add(t);
+    const double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Deletions reach the region headers and the chunk index before anything is compacted
+    storage.closeAll();
+
+    uint64_t fileBytes = 0;
+    for (auto& region : regions) {
+        std::error_code ec;
+        region.fileBytes = fs::file_size(PathProvider::getInstance().getRegionFilePath(options.worldName, region.regionPos), ec);
+        fileBytes += region.fileBytes;
+    }
+
+    size_t compactFailures = 0;
+    if (options.compact) {
+        for (auto& region : regions) {
+            region.chunks.erase(std::remove_if(region.chunks.begin(), region.chunks.end(), [&](const ChunkPos& pos) {
+                return !options.dryRun && !storage.contains(options.worldName, pos);
+            }), region.chunks.end());
+        }
+        storage.closeAll();
+        std::atomic<size_t> failures{0};
+        forEachRegionParallel(options.threads, regions, [&](unsigned, Region& region) {
+            if (!compactRegion(options, region)) ++failures;
+        });
+        compactFailures = failures;
+        // Writes back the chunk index the swapped regions changed
+        storage.closeAll();
+    }
+
+    uint64_t compactedBytes = 0;
+    size_t droppedChunks = 0;
+    std::cout << "regions:\n";
+    for (const auto& region : regions) {
+        compactedBytes += region.compactedBytes;
+        droppedChunks += region.droppedChunks;
+        const fs::path path = PathProvider::getInstance().getRegionFilePath(options.worldName, region.regionPos);
+        std::cout << "  " << path.filename().string() << ": " << region.chunks.size() << " chunks, "
+                  << region.payloadBytes / 1024 << " KB payload, " << region.fileBytes / 1024 << " KB file";
+        if (options.compact) std::cout << ", " << region.compactedBytes / 1024 << " KB compacted";
+        if (region.droppedChunks > 0) std::cout << ", " << region.droppedChunks << " unreadable chunks dropped";
+        std::cout << "\n";
+    }
+
+    const uint64_t voxels = static_cast<uint64_t>(totals.chunks) * ChunkBlockStorage::VOLUME;
+    std::cout << "blocks:\n";
+    for (size_t i = 0; i < totals.blocks.size(); ++i) {
+        if (totals.blocks[i] == 0) continue;
+        std::cout << "  " << toString(static_cast<Blocks>(i)) << ": " << totals.blocks[i]
+                  << " (" << (voxels == 0 ? 0.0 : totals.blocks[i] * 100.0 / voxels) << "%)\n";
+    }
+
+    std::cout << "chunks: " << totals.chunks << " in " << regions.size() << " regions, "
+              << totals.payloadBytes / 1024 << " KB payload, " << fileBytes / 1024 << " KB on disk\n"
+              << "  all air " << totals.airChunks << " (" << percent(totals.airChunks, totals.chunks) << ")"
+              << ", uniform " << totals.uniformChunks << " (" << percent(totals.uniformChunks, totals.chunks) << ")"
+              << ", modified " << totals.modifiedChunks << " (" << percent(totals.modifiedChunks, totals.chunks) << ")"
+              << ", stored in full " << totals.fullChunks << "\n"
+              << "  same as regenerated " << totals.generatedChunks
+              << ", outside radius " << totals.outsideRadius
+              << ", corrupt " << totals.corrupt << "\n"
+              << "  " << (options.dryRun ? "would delete " : "deleted ") << totals.deleted << "\n";
+    if (options.compact) {
+        std::cout << "  compacted " << fileBytes / 1024 << " KB -> " << compactedBytes / 1024 << " KB"
+                  << (droppedChunks > 0 ? ", " + std::to_string(droppedChunks) + " unreadable chunks " +
+                                          (options.dryRun ? "would be dropped" : "dropped") : "")
+                  << (compactFailures > 0 ? ", " + std::to_string(compactFailures) + " regions failed" : "")
+                  << (options.dryRun ? " (dry run)" : "") << "\n";
+    }
+    std::cout << "scanned " << static_cast<int>(totals.chunks / std::max(scanSeconds, 1e-6) * 60.0)
+              << " chunks/min on " << options.threads << " threads\n";
+    return totals.corrupt > 0 || compactFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,491 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #define MINEOX_HAS_IO_URING 1
+    #include <linux/io_uring.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <chrono>
+#endif
+
+#include "Logger.h"
+
+namespace fs = std::filesystem;
+
+struct AsyncRead {
+    fs::path path;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    // ok is false on an I/O error or a short read
+    std::function<void(bool ok, std::string bytes)> onComplete;
+};
+
+// Batched file reads off the calling thread. On Linux requests go through
+// io_uring and up to QUEUE_DEPTH of them are in flight at once; where io_uring
+// is missing, refused or keeps failing, one dedicated I/O thread runs them in
+// order. Completion callbacks run on the I/O thread: keep them short and hand
+// real work to another thread.
+class AsyncFileIO {
+public:
+    static constexpr unsigned QUEUE_DEPTH = 64;
+    // Hard cap on cached descriptors, least recently used ones are closed first
+    static constexpr size_t MAX_OPEN_FILES = 64;
+
+    static AsyncFileIO& getInstance() {
+        static AsyncFileIO instance;
+        return instance;
+    }
+
+    void submitReads(std::vector<AsyncRead> reads) {
+        if (reads.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_stopping) {
+                for (auto& read : reads) {
+                    _queue.push_back(std::move(read));
+                }
+                _submitted += reads.size();
+                _wake.notify_one();
+                return;
+            }
+        }
+        for (auto& read : reads) {
+            runBlocking(read);
+        }
+    }
+
+    // The file at path was replaced or removed: reads submitted from now on open it
+    // again instead of going through a cached descriptor of the old file. Reads
+    // already submitted may still see the old contents. Any thread.
+    void invalidate(const fs::path& path) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _invalidated.push_back(path.string());
+    }
+
+    // Blocks until every request submitted so far has completed
+    void drain() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _drained.wait(lock, [this] { return _completed == _submitted; });
+    }
+
+    // Completes everything queued, then stops the I/O thread. Later submissions run on the caller.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stopping) return;
+            _stopping = true;
+        }
+        _wake.notify_one();
+        if (_thread.joinable()) _thread.join();
+    }
+
+    const char* getBackendName() const {
+        return _usingIoUring.load(std::memory_order_relaxed) ? "io_uring" : "I/O thread";
+    }
+
+    size_t getPending() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return static_cast<size_t>(_submitted - _completed);
+    }
+
+private:
+    AsyncFileIO() {
+#ifdef MINEOX_HAS_IO_URING
+        _usingIoUring = _ring.init(QUEUE_DEPTH);
+        if (!_usingIoUring) {
+            Logger::getInstance().Log("io_uring unavailable, chunk I/O falls back to a dedicated thread", LogLevel::Warning);
+        }
+#endif
+        _thread = std::thread([this] {
+#ifdef MINEOX_HAS_IO_URING
+            if (_usingIoUring) {
+                runIoUring();
+                return;
+            }
+#endif
+            runThread();
+        });
+    }
+
+    ~AsyncFileIO() {
+        shutdown();
+    }
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    // Takes up to max queued requests; waits for one unless dontWait. Empty once stopping and drained.
+    // Invalidations queued before these requests move to invalidated, to be applied first.
+    std::vector<AsyncRead> takeRequests(size_t max, bool dontWait, std::vector<std::string>& invalidated) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!dontWait) {
+            _wake.wait(lock, [this] { return _stopping || !_queue.empty(); });
+        }
+        invalidated.swap(_invalidated);
+        _invalidated.clear();
+        std::vector<AsyncRead> taken;
+        while (!_queue.empty() && taken.size() < max) {
+            taken.push_back(std::move(_queue.front()));
+            _queue.pop_front();
+        }
+        return taken;
+    }
+
+    bool isStoppingAndEmpty() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stopping && _queue.empty();
+    }
+
+    void markCompleted(size_t count) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _completed += count;
+        if (_completed == _submitted) _drained.notify_all();
+    }
+
+    static void complete(AsyncRead& read, bool ok, std::string bytes) {
+        if (read.onComplete) read.onComplete(ok, std::move(bytes));
+    }
+
+    // Blocking fallback, also used for requests io_uring rejected
+    static void runBlocking(AsyncRead& read) {
+        std::string bytes(read.length, '\0');
+        std::ifstream file(read.path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(read.offset));
+        file.read(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        const bool ok = file.good();
+        complete(read, ok, ok ? std::move(bytes) : std::string());
+    }
+
+    void runThread() {
+        std::vector<std::string> invalidated;
+        while (true) {
+            // Nothing cached here, every read opens its file
+            auto reads = takeRequests(QUEUE_DEPTH, false, invalidated);
+            if (reads.empty()) {
+                if (isStoppingAndEmpty()) return;
+                continue;
+            }
+            for (auto& read : reads) {
+                runBlocking(read);
+            }
+            markCompleted(reads.size());
+        }
+    }
+
+#ifdef MINEOX_HAS_IO_URING
+    // Just the parts of io_uring used here, set up with raw syscalls (no liburing)
+    class Ring {
+    public:
+        ~Ring() {
+            if (_sqes) munmap(_sqes, _sqesSize);
+            if (_cqRing && _cqRing != _sqRing) munmap(_cqRing, _cqRingSize);
+            if (_sqRing) munmap(_sqRing, _sqRingSize);
+            if (_fd >= 0) ::close(_fd);
+        }
+
+        bool init(unsigned entries) {
+            io_uring_params params{};
+            _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (_fd < 0) return false;
+
+            _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (singleMap) _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+
+            _sqRing = mapRing(_sqRingSize, IORING_OFF_SQ_RING);
+            if (!_sqRing) return false;
+            _cqRing = singleMap ? _sqRing : mapRing(_cqRingSize, IORING_OFF_CQ_RING);
+            if (!_cqRing) return false;
+            _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+            _sqes = static_cast<io_uring_sqe*>(mapRing(_sqesSize, IORING_OFF_SQES));
+            if (!_sqes) return false;
+
+            char* sq = static_cast<char*>(_sqRing);
+            char* cq = static_cast<char*>(_cqRing);
+            _sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+            _sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            _sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            _sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            _cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            _cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            _cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            _entries = params.sq_entries;
+            return true;
+        }
+
+        // Queues one read; the ring is only touched by the I/O thread
+        bool push(int fd, void* buffer, uint32_t length, uint64_t offset, uint64_t userData) {
+            const unsigned tail = *_sqTail;
+            if (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _entries) return false;
+
+            const unsigned index = tail & _sqMask;
+            io_uring_sqe& sqe = _sqes[index];
+            sqe = io_uring_sqe{};
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = length;
+            sqe.off = offset;
+            sqe.user_data = userData;
+            _sqArray[index] = index;
+            __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+            ++_unsubmitted;
+            return true;
+        }
+
+        // Submits queued entries and waits for at least minComplete completions
+        bool enter(unsigned minComplete) {
+            while (true) {
+                const long result = syscall(__NR_io_uring_enter, _fd, _unsubmitted, minComplete,
+                    minComplete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+                if (result >= 0) {
+                    _unsubmitted -= static_cast<unsigned>(result);
+                    return true;
+                }
+                if (errno != EINTR) return false;
+            }
+        }
+
+        template<typename Fn>
+        size_t reap(Fn&& onCompletion) {
+            unsigned head = *_cqHead;
+            const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+            size_t count = 0;
+            for (; head != tail; ++head, ++count) {
+                const io_uring_cqe& cqe = _cqes[head & _cqMask];
+                onCompletion(cqe.user_data, cqe.res);
+            }
+            __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+            return count;
+        }
+
+    private:
+        void* mapRing(size_t size, off_t offset) {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+            return ptr == MAP_FAILED ? nullptr : ptr;
+        }
+
+        int _fd = -1;
+        void* _sqRing = nullptr;
+        void* _cqRing = nullptr;
+        io_uring_sqe* _sqes = nullptr;
+        size_t _sqRingSize = 0;
+        size_t _cqRingSize = 0;
+        size_t _sqesSize = 0;
+        unsigned* _sqHead = nullptr;
+        unsigned* _sqTail = nullptr;
+        unsigned* _sqArray = nullptr;
+        unsigned* _cqHead = nullptr;
+        unsigned* _cqTail = nullptr;
+        io_uring_cqe* _cqes = nullptr;
+        unsigned _sqMask = 0;
+        unsigned _cqMask = 0;
+        unsigned _entries = 0;
+        unsigned _unsubmitted = 0;
+    };
+
+    // Closed once neither the cache nor a read in flight holds it
+    struct OpenFile {
+        int fd;
+        explicit OpenFile(int fd) : fd(fd) {}
+        ~OpenFile() { ::close(fd); }
+    };
+
+    struct CachedFile {
+        std::shared_ptr<OpenFile> file;
+        std::list<std::string>::iterator lruIt;
+    };
+
+    struct InFlight {
+        AsyncRead read;
+        std::shared_ptr<OpenFile> file;
+        std::string buffer;
+        uint32_t done = 0;  // bytes already read, short reads are resubmitted
+    };
+
+    // Consecutive io_uring_enter failures before the ring is given up
+    static constexpr int MAX_ENTER_FAILURES = 8;
+
+    // nullptr when the file does not open, or when every cached descriptor is
+    // still used by a read in flight and the cache is full
+    std::shared_ptr<OpenFile> openFile(const fs::path& path) {
+        std::string key = path.string();
+        auto it = _files.find(key);
+        if (it != _files.end()) {
+            _fileLru.splice(_fileLru.begin(), _fileLru, it->second.lruIt);
+            return it->second.file;
+        }
+
+        if (_files.size() >= MAX_OPEN_FILES && !evictFile()) return nullptr;
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return nullptr;
+        auto file = std::make_shared<OpenFile>(fd);
+        _fileLru.push_front(key);
+        _files.emplace(std::move(key), CachedFile{ file, _fileLru.begin() });
+        return file;
+    }
+
+    // Closes the least recently used descriptor no read in flight holds
+    bool evictFile() {
+        for (auto it = _fileLru.rbegin(); it != _fileLru.rend(); ++it) {
+            auto cached = _files.find(*it);
+            if (cached->second.file.use_count() > 1) continue;
+            _files.erase(cached);
+            _fileLru.erase(std::next(it).base());
+            return true;
+        }
+        return false;
+    }
+
+    // The descriptor stays open while reads in flight still hold it
+    void dropFile(const std::string& key) {
+        auto it = _files.find(key);
+        if (it == _files.end()) return;
+        _fileLru.erase(it->second.lruIt);
+        _files.erase(it);
+    }
+
+    bool pushOp(InFlight* op) {
+        return _ring.push(op->file->fd, op->buffer.data() + op->done, op->read.length - op->done,
+            op->read.offset + op->done, reinterpret_cast<uint64_t>(op));
+    }
+
+    // Backs off after a failed io_uring_enter. False once it keeps failing: the reads in
+    // flight have then been run blocking and the thread backend takes over.
+    bool handleEnterFailure(int error) {
+        ++_enterFailures;
+        if (_enterFailures < MAX_ENTER_FAILURES) {
+            if (_enterFailures == 1) {
+                Logger::getInstance().Log("io_uring_enter failed, errno " + std::to_string(error) + ", retrying",
+                    LogLevel::Warning);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1 << _enterFailures));
+            return true;
+        }
+
+        Logger::getInstance().Log("io_uring_enter keeps failing, errno " + std::to_string(error) +
+            ", chunk I/O falls back to a dedicated thread", LogLevel::Error);
+        // The kernel may still own these buffers; they are kept until the ring is closed
+        for (auto& [raw, op] : _ops) {
+            runBlocking(op->read);
+            _abandoned.push_back(std::move(op));
+        }
+        const size_t finished = _ops.size();
+        _ops.clear();
+        markCompleted(finished);
+        _files.clear();
+        _fileLru.clear();
+        _usingIoUring = false;
+        return false;
+    }
+
+    void runIoUring() {
+        std::vector<std::string> invalidated;
+        while (true) {
+            // Fill the ring; block for new requests only when nothing is in flight
+            const size_t room = QUEUE_DEPTH - _ops.size();
+            auto reads = room > 0 ? takeRequests(room, !_ops.empty(), invalidated) : std::vector<AsyncRead>{};
+            for (const auto& key : invalidated) {
+                dropFile(key);
+            }
+            invalidated.clear();
+
+            size_t finishedHere = 0;
+            for (auto& read : reads) {
+                auto op = std::make_unique<InFlight>();
+                op->read = std::move(read);
+                op->file = openFile(op->read.path);
+                op->buffer.resize(op->read.length);
+
+                if (op->file && pushOp(op.get())) {
+                    InFlight* raw = op.get();
+                    _ops.emplace(raw, std::move(op));
+                } else {
+                    runBlocking(op->read);
+                    ++finishedHere;
+                }
+            }
+            if (finishedHere > 0) markCompleted(finishedHere);
+
+            if (_ops.empty()) {
+                if (isStoppingAndEmpty()) break;
+                continue;
+            }
+
+            // EBUSY / EAGAIN mean the completion queue is full, reaping below makes room
+            if (_ring.enter(1)) {
+                _enterFailures = 0;
+            } else if (errno != EBUSY && errno != EAGAIN && !handleEnterFailure(errno)) {
+                runThread();
+                return;
+            }
+
+            size_t finished = 0;
+            _ring.reap([&](uint64_t userData, int32_t result) {
+                auto* op = reinterpret_cast<InFlight*>(userData);
+                if (result > 0 && op->done + static_cast<uint32_t>(result) < op->read.length) {
+                    op->done += static_cast<uint32_t>(result);
+                    if (pushOp(op)) return;
+                    // Submission queue full, finish this one blocking
+                    result = -EAGAIN;
+                }
+                ++finished;
+                auto node = _ops.extract(op);
+                auto& owned = node.mapped();
+                if (result == -EINVAL || result == -EOPNOTSUPP || result == -EAGAIN) {
+                    // Kernel without IORING_OP_READ (before 5.6), or nowhere left to resubmit
+                    runBlocking(owned->read);
+                    return;
+                }
+                const bool ok = result >= 0 && owned->done + static_cast<uint32_t>(result) == owned->read.length;
+                complete(owned->read, ok, ok ? std::move(owned->buffer) : std::string());
+            });
+            if (finished > 0) markCompleted(finished);
+        }
+
+        _files.clear();
+        _fileLru.clear();
+    }
+
+    std::unordered_map<std::string, CachedFile> _files;
+    std::list<std::string> _fileLru;  // most recently used first
+    std::unordered_map<InFlight*, std::unique_ptr<InFlight>> _ops;
+    std::vector<std::unique_ptr<InFlight>> _abandoned;
+    int _enterFailures = 0;
+    // Declared after _abandoned: closing the ring first cancels what the kernel still holds
+    Ring _ring;
+#endif
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _drained;
+    std::deque<AsyncRead> _queue;
+    std::vector<std::string> _invalidated;
+    uint64_t _submitted = 0;
+    uint64_t _completed = 0;
+    bool _stopping = false;
+    std::atomic<bool> _usingIoUring{false};
+    std::thread _thread;
+};
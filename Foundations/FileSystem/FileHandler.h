@@ -8,9 +8,12 @@
 #include <mutex>
 #include <vector>
 #include <iostream>
-#include <windows.h>
 #include <set>
 
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
 namespace fs = std::filesystem;
 
 class FileHandler {
@@ -94,12 +97,22 @@ public:
         }
     }
 
-private:
-    FileHandler() {
+    // Folder of the running executable, the bundled data/ folder sits next to it
+    static fs::path getExecutableDir() {
+#ifdef _WIN32
         char buffer[MAX_PATH];
         GetModuleFileNameA(NULL, buffer, MAX_PATH);
-        fs::path exePath(buffer);
-        fs::path exeDir = exePath.parent_path();
+        return fs::path(buffer).parent_path();
+#else
+        std::error_code ec;
+        fs::path exePath = fs::read_symlink("/proc/self/exe", ec);
+        return ec ? fs::current_path() : exePath.parent_path();
+#endif
+    }
+
+private:
+    FileHandler() {
+        fs::path exeDir = getExecutableDir();
         fs::path dataPath = exeDir / "data";
 
         if (!fs::exists(dataPath)) {
@@ -112,10 +125,7 @@ private:
         if (!fs::exists(fontPath)) {
             std::cout << "Arial.ttf not found in target folder. Copying from data/..." << std::endl;
 
-            char buffer[MAX_PATH];
-            GetModuleFileNameA(NULL, buffer, MAX_PATH);
-            fs::path exePath(buffer);
-            fs::path exeDir = exePath.parent_path();
+            fs::path exeDir = getExecutableDir();
             fs::path sourceFont = exeDir / "data" / "fonts" / "arial.ttf";
 
             if (!fs::exists(sourceFont)) {
@@ -132,10 +142,7 @@ private:
     friend class PathProvider;
 
     void ensureShaderPresent(const fs::path& shaderPath) {
-        char buffer[MAX_PATH];
-        GetModuleFileNameA(NULL, buffer, MAX_PATH);
-        fs::path exePath(buffer);
-        fs::path exeDir = exePath.parent_path();
+        fs::path exeDir = getExecutableDir();
 
         fs::path sourceShaders = exeDir / "data" / "shaders";
 
@@ -179,10 +186,7 @@ private:
     friend class PathProvider;
 
     void ensureTexturesPresent(const fs::path& texturesPath) {
-        char buffer[MAX_PATH];
-        GetModuleFileNameA(NULL, buffer, MAX_PATH);
-        fs::path exePath(buffer);
-        fs::path exeDir = exePath.parent_path();
+        fs::path exeDir = getExecutableDir();
 
         fs::path sourceTextures = exeDir / "data" / "textures";
 
@@ -193,10 +197,7 @@ private:
     friend class PathProvider;
 
     void ensureModelsPresent(const fs::path& modelsPath) {
-        char buffer[MAX_PATH];
-        GetModuleFileNameA(NULL, buffer, MAX_PATH);
-        fs::path exePath(buffer);
-        fs::path exeDir = exePath.parent_path();
+        fs::path exeDir = getExecutableDir();
 
         fs::path sourceModels = exeDir / "data" / "models";
 
@@ -207,10 +208,7 @@ private:
     friend class PathProvider;
 
     void ensureJsonConfigPresent(const fs::path& jsonConfigPath) {
-        char buffer[MAX_PATH];
-        GetModuleFileNameA(NULL, buffer, MAX_PATH);
-        fs::path exePath(buffer);
-        fs::path exeDir = exePath.parent_path();
+        fs::path exeDir = getExecutableDir();
 
         fs::path sourceJsonConfigs = exeDir / "data" / "jsonConfigs";
 
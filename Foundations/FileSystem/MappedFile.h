@@ -0,0 +1,111 @@
+#pragma once
+
+#include <filesystem>
+#include <algorithm>
+#include <cstddef>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// Read-only memory mapping of a whole file. Writes made through another handle
+// are visible through the mapping, but bytes past the size at map() time are
+// not: remap after the file grows.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool map(const fs::path& path) {
+        unmap();
+#ifdef _WIN32
+        _file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+            unmap();
+            return false;
+        }
+        _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapping) {
+            unmap();
+            return false;
+        }
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_data) {
+            unmap();
+            return false;
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+
+        _data = static_cast<const char*>(data);
+        _size = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void unmap() {
+#ifdef _WIN32
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data) munmap(const_cast<char*>(_data), _size);
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    // Drops the pages of [offset, offset + length) from this process; they stay in the
+    // OS page cache, so the next access is a cheap soft fault instead of a disk read
+    void release(size_t offset, size_t length) const {
+        if (!_data || offset >= _size || length == 0) return;
+        length = std::min(length, _size - offset);
+#ifdef _WIN32
+        // Unlocking pages that were never locked trims them from the working set
+        VirtualUnlock(const_cast<char*>(_data + offset), length);
+#else
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t begin = offset / page * page;
+        madvise(const_cast<char*>(_data + begin), offset + length - begin, MADV_DONTNEED);
+#endif
+    }
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool isMapped() const { return _data != nullptr; }
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#endif
+};
@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <stdexcept>
 #include <array>
+#include <cstdlib>
+#include <string>
 #include "ChunkPos.h"
 
 #include "FileHandler.h"
@@ -48,6 +50,7 @@ public:
         return getBlocksTextureFolderPath() / (blockStringRepresentation + ".png");
     }
 
+    // One file per chunk, the layout before region files. Only read by the converter now.
     fs::path getWorldChunksPath(std::string worldName) const {
         return worldsPath / worldName / "chunks";
     }
@@ -56,6 +59,27 @@ public:
         return getWorldChunksPath(worldName) / chunkPos.toString();
     }
 
+    fs::path getWorldRegionsPath(std::string worldName) const {
+        return worldsPath / worldName / "regions";
+    }
+
+    fs::path getRegionFilePath(std::string worldName, glm::ivec3 regionPos) const {
+        return getWorldRegionsPath(worldName) / ("Region_" + std::to_string(regionPos.x) + "_" +
+            std::to_string(regionPos.y) + "_" + std::to_string(regionPos.z));
+    }
+
+    fs::path getChunkIndexPath(std::string worldName) const {
+        return getWorldRegionsPath(worldName) / "chunks.idx";
+    }
+
+    fs::path getWorldInfoPath(std::string worldName) const {
+        return worldsPath / worldName / "world.info";
+    }
+
+    fs::path getWorldMeshCachePath(std::string worldName) const {
+        return worldsPath / worldName / "meshcache";
+    }
+
     fs::path getFontsPath() const {
         return dataPath / "fonts";
     }
@@ -139,10 +163,16 @@ private:
     }
 
     PathProvider() {
+#ifdef _WIN32
         const char* appdata = std::getenv("APPDATA");
         if (!appdata) throw std::runtime_error("APPDATA env var not found");
         rootPath = fs::path(appdata) / ".mineox";
         configPath = rootPath / "config";
+#else
+        // XDG base directories: saves and data under XDG_DATA_HOME, config under XDG_CONFIG_HOME
+        rootPath = xdgPath("XDG_DATA_HOME", ".local/share") / "mineox";
+        configPath = xdgPath("XDG_CONFIG_HOME", ".config") / "mineox";
+#endif
         logsPath = rootPath / "logs";
         dataPath = rootPath / "data";
         worldsPath = rootPath / "saves";
@@ -154,6 +184,17 @@ private:
 
     ~PathProvider() = default;
 
+#ifndef _WIN32
+    // $variable when set to an absolute path, as the spec requires, else $HOME/fallback
+    static fs::path xdgPath(const char* variable, const char* fallback) {
+        const char* value = std::getenv(variable);
+        if (value && value[0] == '/') return fs::path(value);
+        const char* home = std::getenv("HOME");
+        if (!home) throw std::runtime_error(std::string("Neither ") + variable + " nor HOME env var is set");
+        return fs::path(home) / fallback;
+    }
+#endif
+
     fs::path rootPath;
     fs::path configPath;
     fs::path logsPath;
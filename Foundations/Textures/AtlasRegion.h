@@ -0,0 +1,6 @@
+#pragma once
+
+struct AtlasRegion {
+    float u0, v0; // Нижний левый угол
+    float u1, v1; // Верхний правый угол
+};
@@ -10,14 +10,10 @@
 
 #include "PathProvider.h"
 #include "Logger.h"
+#include "AtlasRegion.h"
 
 namespace fs = std::filesystem;
 
-struct AtlasRegion {
-    float u0, v0; // Нижний левый угол
-    float u1, v1; // Верхний правый угол
-};
-
 class TextureManager {
 private:
     int textureSize = 16;
@@ -14,8 +14,12 @@ public:
         size_t headIdx = head.load(std::memory_order_relaxed);
         size_t nextHead = increment(headIdx);
 
-        if (nextHead == tail.load(std::memory_order_acquire)) {
-            tail.store(increment(tail.load(std::memory_order_relaxed)), std::memory_order_release);
+        // Full: claim the oldest task the way a consumer would and destroy it now, so the
+        // future of a dropped packaged_task breaks here and not when its slot is next reused
+        size_t tailIdx = tail.load(std::memory_order_acquire);
+        if (nextHead == tailIdx &&
+            tail.compare_exchange_strong(tailIdx, increment(tailIdx), std::memory_order_acq_rel)) {
+            buffer[tailIdx] = Task{};
         }
 
         buffer[headIdx] = std::move(item);
@@ -49,6 +49,10 @@ public:
         return enqueueChunkTask(std::forward<F>(f), std::forward<Args>(args)...);
     }
 
+    size_t getWorkerCount() const {
+        return workers.size();
+    }
+
 private:
     ThreadPool()
         : stopping(false)
@@ -37,7 +37,7 @@ public:
         visibleChunks.reserve(loadedChunks.size());
 
         for (const auto& [pos, chunkPtr] : loadedChunks) {
-            if (chunkPtr) {
+            if (chunkPtr && !chunkPtr->isEmpty()) {
                 visibleChunks.push_back(chunkPtr.get());
             }
         }
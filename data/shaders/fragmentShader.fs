@@ -3,7 +3,7 @@
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
-flat in int TextureIndex;
+flat in vec4 AtlasRect;
 in vec4 FragPosLightSpace;
 
 uniform sampler2D shadowMap;
@@ -105,7 +105,10 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal)
 
 void main()
 {
-    vec4 texColor = texture(atlasTexture, TexCoords);
+    // TexCoords counts texture repeats, a merged quad wraps each one into the texture's atlas region.
+    // Gradients come from the unwrapped coordinates so the wrap seams do not pick another mip level.
+    vec2 atlasUV = AtlasRect.xy + fract(TexCoords) * AtlasRect.zw;
+    vec4 texColor = textureGrad(atlasTexture, atlasUV, dFdx(TexCoords) * AtlasRect.zw, dFdy(TexCoords) * AtlasRect.zw);
 
     vec3 norm = normalize(Normal);
     vec3 lightDirNorm = normalize(-lightDir);
@@ -3,12 +3,12 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in int aTextureIndex;
+layout (location = 3) in vec4 aAtlasRect;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
-flat out int TextureIndex;
+flat out vec4 AtlasRect;
 
 // Добавляем координаты в пространстве света (shadow map)
 out vec4 FragPosLightSpace;
@@ -23,7 +23,7 @@ void main()
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoords = aTexCoords; 
-    TextureIndex = aTextureIndex;
+    AtlasRect = aAtlasRect;
 
     FragPosLightSpace = lightSpaceMatrix * model * vec4(aPos, 1.0);
 
@@ -29,6 +29,12 @@
 #include "WireFrameCube.h"
 #include "SkySettings.h"
 #include "f3InfoScreen.h"
+#include "ChunkSaver.h"
+#include "RegionStorage.h"
+#include "AsyncFileIO.h"
+#include "ChunkMeshCache.h"
+#include "ChunkMeshScheduler.h"
+#include "ChunkUploadScheduler.h"
 #include <GL/glext.h>
 #include "GLSettingsController.h"
 
@@ -126,12 +132,12 @@ int main() {
     stateController.changeState(std::make_unique<MainMenuState>());
 
     camera = Camera();
-    World world(12345, "New world"); // Later, get seed and world name from user input
+    World world(WorldInfo::DEFAULT_SEED, "New world"); // Later, get seed and world name from user input
     ServiceLocator::ProvideWorld(&world);
     //world.initWorld(camera.Position);
 
     std::vector<std::filesystem::path> dirsToCheck = {
-        pathProvider.getWorldChunksPath(world.getWorldName()),
+        pathProvider.getWorldRegionsPath(world.getWorldName()),
         pathProvider.getDataPath(),
         pathProvider.getTextureFolderPath(),
         pathProvider.getBlocksTextureFolderPath()
@@ -183,6 +189,7 @@ int main() {
     glm::mat4 model = glm::mat4(1.0f);
 
     textureManager.bindTextures();
+    blockCacheController.bakeModels(textureManager.getAtlasRegions());
 
     while (!glfwWindowShouldClose(window)) {
         if(window) {
@@ -260,6 +267,18 @@ int main() {
     }
 
     Logger::getInstance().Log("Application shutdown", LogLevel::Warning, LogOutput::Both, LogWriteMode::Append);
+    // The window stays open until the world is on disk
+    world.save([window](size_t done, size_t total) {
+        std::string title = "MineOx - saving world " + std::to_string(total == 0 ? 100 : done * 100 / total) + "%";
+        glfwSetWindowTitle(window, title.c_str());
+        glfwPollEvents();
+    });
+    ChunkSaver::getInstance().shutdown();
+    AsyncFileIO::getInstance().shutdown();
+    ChunkMeshScheduler::getInstance().shutdown();
+    ChunkMeshCache::getInstance().shutdown();
+    RegionStorage::getInstance().closeAll();
+    ChunkUploadScheduler::getInstance().shutdown();
     windowController.shutdown();
     return 0;
 }